@@ -0,0 +1,81 @@
+#include "arena.hpp"
+//    arena.cpp - Allocate many small objects, and free them all at once.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    // chunks double in size up to this, so there are only ever a few
+    static const size_t max_chunk = 16 * 1024 * 1024;
+
+    Arena::Arena(size_t first_chunk)
+    : chunks(nullptr)
+    , cur(nullptr)
+    , end(nullptr)
+    , next_size(first_chunk)
+    , total(0)
+    {}
+
+    Arena::~Arena()
+    {
+        while (chunks)
+        {
+            Chunk *prev = chunks->prev;
+            free(chunks);
+            chunks = prev;
+        }
+    }
+
+    char *Arena::grow(size_t size, size_t align)
+    {
+        size_t need = sizeof(Chunk) + size + align;
+        size_t chunk_size = std::max(next_size, need);
+        next_size = std::min(next_size * 2, max_chunk);
+        Chunk *c = static_cast<Chunk *>(malloc(chunk_size));
+        if (!c)
+            throw std::bad_alloc();
+        c->prev = chunks;
+        chunks = c;
+        cur = reinterpret_cast<char *>(c + 1);
+        end = reinterpret_cast<char *>(c) + chunk_size;
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~uintptr_t(align - 1);
+        return reinterpret_cast<char *>(p);
+    }
+
+    const char *Arena::copy(const char *b, const char *e)
+    {
+        char *out = static_cast<char *>(allocate(e - b, 1));
+        if (b != e)
+            memcpy(out, b, e - b);
+        return out;
+    }
+
+    size_t Arena::bytes() const
+    {
+        return total;
+    }
+} // namespace sexpr
+} // namespace tmwa
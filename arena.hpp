@@ -0,0 +1,112 @@
+#ifndef TMWA_SEXPR_ARENA_HPP
+#define TMWA_SEXPR_ARENA_HPP
+//    arena.hpp - Allocate many small objects, and free them all at once.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <type_traits>
+
+#include <cstddef>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// A bump allocator: memory comes from a few large chunks, and is
+    /// only given back when the whole Arena is destroyed.
+    ///
+    /// Nothing allocated from it is destroyed by it, either; that is
+    /// left to the owner (see Document).
+    class Arena
+    {
+        struct Chunk
+        {
+            Chunk *prev;
+        };
+        Chunk *chunks;
+        char *cur, *end;
+        size_t next_size;
+        size_t total;
+
+        char *grow(size_t size, size_t align);
+    public:
+        explicit Arena(size_t first_chunk = 64 * 1024);
+        Arena(const Arena&) = delete;
+        Arena& operator = (const Arena&) = delete;
+        ~Arena();
+
+        void *allocate(size_t size, size_t align);
+        /// Copy bytes into the arena, returning where they now are.
+        const char *copy(const char *b, const char *e);
+        /// How much has been allocated from it so far.
+        size_t bytes() const;
+    };
+
+    /// Allocates from an Arena, or from the heap if it has none.
+    ///
+    /// Copies of a container never share its arena, so they can outlive it.
+    template<class T>
+    class ArenaAllocator
+    {
+        template<class U>
+        friend class ArenaAllocator;
+
+        Arena *arena;
+    public:
+        typedef T value_type;
+        typedef std::true_type propagate_on_container_move_assignment;
+        typedef std::true_type propagate_on_container_swap;
+
+        ArenaAllocator(Arena *a = nullptr)
+        : arena(a)
+        {}
+        template<class U>
+        ArenaAllocator(const ArenaAllocator<U>& r)
+        : arena(r.arena)
+        {}
+
+        T *allocate(size_t n);
+        void deallocate(T *p, size_t n);
+        ArenaAllocator select_on_container_copy_construction() const;
+        Arena *get_arena() const { return arena; }
+        // std::allocator_traits falls back to doing these itself, but
+        // unoptimized, that costs a lot more stack for each element a
+        // container destroys, and destroying a tree recurses through it
+        template<class U, class... A>
+        void construct(U *p, A&&... a);
+        template<class U>
+        void destroy(U *p);
+
+        template<class U>
+        friend bool operator == (const ArenaAllocator& l, const ArenaAllocator<U>& r)
+        {
+            return l.arena == r.get_arena();
+        }
+        template<class U>
+        friend bool operator != (const ArenaAllocator& l, const ArenaAllocator<U>& r)
+        {
+            return l.arena != r.get_arena();
+        }
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#include "arena.tcc"
+
+#endif //TMWA_SEXPR_ARENA_HPP
@@ -0,0 +1,77 @@
+//    arena.tcc - implementation of inlines and templates in arena.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <cstdint>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    inline void *Arena::allocate(size_t size, size_t align)
+    {
+        uintptr_t p = (reinterpret_cast<uintptr_t>(cur) + align - 1) & ~uintptr_t(align - 1);
+        char *out = reinterpret_cast<char *>(p);
+        if (out > end or size > size_t(end - out))
+            out = grow(size, align);
+        cur = out + size;
+        total += size;
+        return out;
+    }
+
+    template<class T>
+    T *ArenaAllocator<T>::allocate(size_t n)
+    {
+        if (arena)
+            return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+        return std::allocator<T>().allocate(n);
+    }
+
+    template<class T>
+    void ArenaAllocator<T>::deallocate(T *p, size_t n)
+    {
+        // memory from an arena is freed with the arena
+        if (!arena)
+            std::allocator<T>().deallocate(p, n);
+    }
+
+    template<class T>
+    ArenaAllocator<T> ArenaAllocator<T>::select_on_container_copy_construction() const
+    {
+        return ArenaAllocator();
+    }
+
+    template<class T>
+    template<class U, class... A>
+    void ArenaAllocator<T>::construct(U *p, A&&... a)
+    {
+        new (p) U(std::forward<A>(a)...);
+    }
+
+    template<class T>
+    template<class U>
+    void ArenaAllocator<T>::destroy(U *p)
+    {
+        p->~U();
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,421 @@
+#include "binary.hpp"
+//    binary.cpp - A compact binary encoding of S-expressions.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <algorithm>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+#include <cstring>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    using binary::Kind;
+    using binary::zigzag;
+    using binary::unzigzag;
+
+    BadEncoding::BadEncoding(size_t offset, const std::string& what)
+    {
+        std::ostringstream out;
+        out << "Bad binary S-expression at byte " << offset << ": " << what;
+        msg = out.str();
+    }
+
+    const char *BadEncoding::what() const noexcept
+    {
+        return msg.c_str();
+    }
+
+    BadEncoding::~BadEncoding() noexcept = default;
+
+    static size_t varint_size(uint64_t v)
+    {
+        size_t n = 1;
+        while (v >= 0x80)
+        {
+            v >>= 7;
+            ++n;
+        }
+        return n;
+    }
+
+    static size_t head_size(uint64_t n)
+    {
+        return n < binary::head_max ? 1 : 1 + varint_size(n - binary::head_max);
+    }
+
+    static char *put_varint(char *out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            *out++ = static_cast<char>(v | 0x80);
+            v >>= 7;
+        }
+        *out++ = static_cast<char>(v);
+        return out;
+    }
+
+    static char *put_head(char *out, Kind k, uint64_t n)
+    {
+        uint8_t kind = static_cast<uint8_t>(k);
+        if (n < binary::head_max)
+        {
+            *out++ = static_cast<char>(kind | n << binary::kind_bits);
+            return out;
+        }
+        *out++ = static_cast<char>(kind | binary::head_max << binary::kind_bits);
+        return put_varint(out, n - binary::head_max);
+    }
+
+    static char *put_bytes(char *out, Kind k, const char *b, const char *e)
+    {
+        out = put_head(out, k, e - b);
+        memcpy(out, b, e - b);
+        return out + (e - b);
+    }
+
+    // tokens by their bytes, so counting a TokenRef needn't intern it
+    struct SliceHash
+    {
+        size_t operator()(Slice s) const
+        {
+            // FNV-1a
+            uint64_t h = 0xcbf29ce484222325;
+            for (char c : s)
+                h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+            return h;
+        }
+    };
+    struct SliceEqual
+    {
+        bool operator()(Slice l, Slice r) const
+        {
+            return l.size() == r.size() and std::equal(l.begin(), l.end(), r.begin());
+        }
+    };
+
+    static Slice text(Symbol s)
+    {
+        return Slice(s.begin(), s.end());
+    }
+
+    /// Three passes: count the tokens, to make the symbol table;
+    /// measure every list, so the output can be allocated once and
+    /// each list's length written before its elements; and write.
+    class Encoder
+    {
+        Symbols symbols;
+        struct Use
+        {
+            size_t count, first;
+        };
+        std::unordered_map<Slice, Use, SliceHash, SliceEqual> uses;
+        std::unordered_map<Slice, size_t, SliceHash, SliceEqual> index;
+        std::vector<Slice> table;
+        // the byte length of each list's elements, in preorder
+        std::vector<size_t> lengths;
+        size_t next_length;
+
+        void count(Slice s)
+        {
+            Use& u = uses[s];
+            if (!u.count++)
+                u.first = uses.size();
+        }
+
+        void count(const SExpr& sex)
+        {
+            if (const List *l = sex.get_if<List>())
+                for (const SExpr& e : *l)
+                    count(e);
+            else if (const Token *t = sex.get_if<Token>())
+                count(text(t->value));
+            else if (const TokenRef *t = sex.get_if<TokenRef>())
+                count(t->value);
+        }
+
+        size_t token_size(Slice s)
+        {
+            auto it = index.find(s);
+            if (it != index.end())
+                return head_size(it->second);
+            return head_size(s.size()) + s.size();
+        }
+
+        char *put_token(char *out, Slice s)
+        {
+            auto it = index.find(s);
+            if (it != index.end())
+                return put_head(out, Kind::symbol, it->second);
+            return put_bytes(out, Kind::token, s.begin(), s.end());
+        }
+
+        size_t measure(const SExpr& sex);
+        char *put(char *out, const SExpr& sex);
+    public:
+        Encoder(Symbols s)
+        : symbols(s)
+        , uses()
+        , index()
+        , table()
+        , lengths()
+        , next_length()
+        {}
+
+        std::string encode(const List& forms);
+    };
+
+    size_t Encoder::measure(const SExpr& sex)
+    {
+        if (const List *l = sex.get_if<List>())
+        {
+            size_t slot = lengths.size();
+            lengths.push_back(0);
+            size_t len = 0;
+            for (const SExpr& e : *l)
+                len += measure(e);
+            lengths[slot] = len;
+            return head_size(l->size()) + varint_size(len) + len;
+        }
+        if (const Int *i = sex.get_if<Int>())
+            return head_size(zigzag(i->value));
+        if (const String *s = sex.get_if<String>())
+            return head_size(s->value.size()) + s->value.size();
+        if (const StringRef *s = sex.get_if<StringRef>())
+            return head_size(s->value.size()) + s->value.size();
+        if (const Token *t = sex.get_if<Token>())
+            return token_size(text(t->value));
+        if (const TokenRef *t = sex.get_if<TokenRef>())
+            return token_size(t->value);
+        return 1;
+    }
+
+    char *Encoder::put(char *out, const SExpr& sex)
+    {
+        if (const List *l = sex.get_if<List>())
+        {
+            out = put_head(out, Kind::list, l->size());
+            out = put_varint(out, lengths[next_length++]);
+            for (const SExpr& e : *l)
+                out = put(out, e);
+            return out;
+        }
+        if (const Int *i = sex.get_if<Int>())
+            return put_head(out, Kind::integer, zigzag(i->value));
+        if (const String *s = sex.get_if<String>())
+            return put_bytes(out, Kind::string, s->value.data(), s->value.data() + s->value.size());
+        if (const StringRef *s = sex.get_if<StringRef>())
+            return put_bytes(out, Kind::string, s->value.begin(), s->value.end());
+        if (const Token *t = sex.get_if<Token>())
+            return put_token(out, text(t->value));
+        if (const TokenRef *t = sex.get_if<TokenRef>())
+            return put_token(out, t->value);
+        return put_head(out, Kind::nil, 0);
+    }
+
+    std::string Encoder::encode(const List& forms)
+    {
+        if (symbols == Symbols::table)
+        {
+            for (const SExpr& sex : forms)
+                count(sex);
+            for (const auto& pair : uses)
+                if (pair.second.count > 1)
+                    table.push_back(pair.first);
+            // the most used get the one byte indices
+            std::sort(table.begin(), table.end(),
+                    [this](Slice l, Slice r)
+                    {
+                        const Use& lu = uses[l];
+                        const Use& ru = uses[r];
+                        if (lu.count != ru.count)
+                            return lu.count > ru.count;
+                        return lu.first < ru.first;
+                    });
+            for (size_t i = 0; i != table.size(); ++i)
+                index[table[i]] = i;
+        }
+
+        size_t total = sizeof(binary::magic) + varint_size(table.size());
+        for (Slice s : table)
+            total += varint_size(s.size()) + s.size();
+        total += varint_size(forms.size());
+        for (const SExpr& sex : forms)
+            total += measure(sex);
+
+        std::string buf(total, '\0');
+        char *out = &buf[0];
+        memcpy(out, binary::magic, sizeof(binary::magic));
+        out += sizeof(binary::magic);
+        out = put_varint(out, table.size());
+        for (Slice s : table)
+        {
+            out = put_varint(out, s.size());
+            memcpy(out, s.begin(), s.size());
+            out += s.size();
+        }
+        out = put_varint(out, forms.size());
+        for (const SExpr& sex : forms)
+            out = put(out, sex);
+        return buf;
+    }
+
+    std::string encode(const List& forms, Symbols symbols)
+    {
+        return Encoder(symbols).encode(forms);
+    }
+
+    void binary::Reader::fail(const char *where, const std::string& what) const
+    {
+        throw BadEncoding(where - start, what);
+    }
+
+    uint64_t binary::Reader::start_document()
+    {
+        if (static_cast<size_t>(end - p) < sizeof(binary::magic)
+                or memcmp(p, binary::magic, sizeof(binary::magic)) != 0)
+            fail(p, "not a binary S-expression document");
+        p += sizeof(binary::magic);
+        uint64_t symbols = varint();
+        // each symbol is at least one byte
+        if (symbols > static_cast<uint64_t>(end - p))
+            fail(p, "symbol count exceeds the document");
+        return symbols;
+    }
+
+    class Decoder
+    {
+        binary::Reader in;
+        Atoms atoms;
+        // only interned when copying, since borrowed tokens needn't be
+        std::vector<Slice> table;
+        std::vector<Symbol> symbols;
+        size_t depth;
+
+        SExpr node();
+        SExpr atom(Kind kind, uint64_t n, const char *here);
+        List list(uint64_t count, const char *list_end);
+    public:
+        Decoder(const char *b, const char *e, Atoms a)
+        : in(b, b, e)
+        , atoms(a)
+        , table()
+        , symbols()
+        , depth()
+        {}
+
+        List decode();
+    };
+
+    SExpr Decoder::node()
+    {
+        const char *here = in.p;
+        uint64_t n;
+        Kind kind = in.head(n);
+        // only lists recurse, so keep everything else out of this frame
+        if (kind != Kind::list)
+            return atom(kind, n, here);
+        uint64_t len = in.varint();
+        if (len > static_cast<uint64_t>(in.end - in.p))
+            in.fail(here, "truncated list");
+        if (depth >= Lexer::default_max_depth)
+            in.fail(here, "list nested too deeply");
+        ++depth;
+        List l = list(n, in.p + len);
+        --depth;
+        return SExpr(std::move(l));
+    }
+
+    SExpr Decoder::atom(Kind kind, uint64_t n, const char *here)
+    {
+        switch (kind)
+        {
+        case Kind::nil:
+            return SExpr();
+        case Kind::list:
+            break;
+        case Kind::integer:
+            return Int(unzigzag(n));
+        case Kind::string:
+        {
+            Slice s = in.bytes(n);
+            if (atoms == Atoms::borrow)
+                return StringRef(s);
+            return String(s.begin(), s.end());
+        }
+        case Kind::token:
+        {
+            Slice s = in.bytes(n);
+            if (atoms == Atoms::borrow)
+                return TokenRef(s);
+            return Token(s.begin(), s.end());
+        }
+        case Kind::symbol:
+            if (n >= table.size())
+                in.fail(here, "symbol index out of range");
+            if (atoms == Atoms::borrow)
+                return TokenRef(table[n]);
+            return Token(symbols[n]);
+        }
+        in.fail(here, "unknown kind");
+    }
+
+    List Decoder::list(uint64_t count, const char *list_end)
+    {
+        const char *here = in.p;
+        // each element is at least one byte
+        if (count > static_cast<uint64_t>(list_end - in.p))
+            in.fail(here, "list count exceeds its length");
+        List l;
+        l.reserve(count);
+        const char *outer_end = in.end;
+        in.end = list_end;
+        for (uint64_t i = 0; i != count; ++i)
+            l.push_back(node());
+        if (in.p != list_end)
+            in.fail(here, "list length doesn't match its elements");
+        in.end = outer_end;
+        return l;
+    }
+
+    List Decoder::decode()
+    {
+        uint64_t count = in.start_document();
+        table.reserve(count);
+        for (uint64_t i = 0; i != count; ++i)
+        {
+            Slice s = in.bytes(in.varint());
+            table.push_back(s);
+            if (atoms == Atoms::copy)
+                symbols.emplace_back(s.begin(), s.end());
+        }
+        uint64_t forms = in.varint();
+        return list(forms, in.end);
+    }
+
+    List decode(const char *b, const char *e, Atoms atoms)
+    {
+        return Decoder(b, e, atoms).decode();
+    }
+} // namespace sexpr
+} // namespace tmwa
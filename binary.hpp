@@ -0,0 +1,129 @@
+#ifndef TMWA_SEXPR_BINARY_HPP
+#define TMWA_SEXPR_BINARY_HPP
+//    binary.hpp - A compact binary encoding of S-expressions.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <exception>
+#include <string>
+
+#include <cstdint>
+
+#include "parser.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Thrown for input that is not a well-formed binary document.
+    class BadEncoding : public std::exception
+    {
+        std::string msg;
+    public:
+        BadEncoding(size_t offset, const std::string& what);
+        virtual const char *what() const noexcept override;
+        ~BadEncoding() noexcept;
+    };
+
+    /// A document is the magic bytes "\0sx\1", a symbol table,
+    /// a count of forms and then the forms.
+    ///
+    /// Every count, length and number is a head or a varint. A head
+    /// is one byte: the low 3 bits are a Kind and the high 5 a number,
+    /// or 31, in which case the number minus 31 follows as a varint.
+    /// A varint is little-endian, 7 bits per byte, with the high bit
+    /// set on every byte but the last.
+    ///
+    /// The symbol table is a varint count, and then each symbol's
+    /// varint length and bytes. Each node is a head, then:
+    ///   nil:    nothing, the number is 0
+    ///   list:   the number is the element count; a varint byte length
+    ///           of the elements, so that readers can skip them; the
+    ///           elements
+    ///   int:    the number is the value, zigzag encoded
+    ///   string: the number is the length; the bytes, unescaped
+    ///   token:  as string
+    ///   symbol: the number is an index into the symbol table
+    namespace binary
+    {
+        enum class Kind : uint8_t
+        {
+            nil,
+            list,
+            integer,
+            string,
+            token,
+            symbol,
+        };
+        constexpr char magic[4] = {'\0', 's', 'x', '\1'};
+        constexpr unsigned kind_bits = 3;
+        constexpr uint64_t head_max = 31;
+
+        uint64_t zigzag(int64_t v);
+        int64_t unzigzag(uint64_t u);
+
+        /// Bounds-checked reading of [p, end), for decoders and views.
+        /// Errors are reported as offsets from start.
+        class Reader
+        {
+        public:
+            const char *start, *p, *end;
+
+            Reader(const char *s, const char *b, const char *e)
+            : start(s)
+            , p(b)
+            , end(e)
+            {}
+
+            [[noreturn]]
+            void fail(const char *where, const std::string& what) const;
+            uint64_t varint();
+            /// Returns the kind, and sets n to the number.
+            Kind head(uint64_t& n);
+            Slice bytes(uint64_t n);
+            /// Check the magic, and read the symbol table's count.
+            uint64_t start_document();
+        };
+    } // namespace binary
+
+    enum class Symbols
+    {
+        /// Every token's bytes are written where it is used.
+        inline_,
+        /// Tokens used more than once are written once, in the symbol
+        /// table, most used first, and referred to by index.
+        table,
+    };
+
+    /// Encode forms, which may contain borrowed atoms.
+    std::string encode(const List& forms, Symbols symbols = Symbols::table);
+
+    /// Decode a whole document, that prints the same as the forms
+    /// that were encoded. With Atoms::borrow, strings and tokens
+    /// that aren't in the symbol table point into [b, e),
+    /// which must outlive them.
+    ///
+    /// Throws BadEncoding if [b, e) isn't exactly one document.
+    List decode(const char *b, const char *e, Atoms atoms = Atoms::copy);
+} // namespace sexpr
+} // namespace tmwa
+
+#include "binary.tcc"
+
+#endif //TMWA_SEXPR_BINARY_HPP
@@ -0,0 +1,76 @@
+//    binary.tcc - implementation of inlines and templates in binary.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+namespace tmwa
+{
+namespace sexpr
+{
+namespace binary
+{
+    inline uint64_t zigzag(int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    inline int64_t unzigzag(uint64_t u)
+    {
+        return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+    }
+
+    inline uint64_t Reader::varint()
+    {
+        // the common case: one byte
+        if (p != end and !(*p & 0x80))
+            return static_cast<uint8_t>(*p++);
+        const char *first = p;
+        uint64_t v = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7)
+        {
+            if (p == end)
+                fail(first, "truncated number");
+            uint8_t byte = *p++;
+            v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return v;
+        }
+        fail(first, "number too long");
+    }
+
+    inline Kind Reader::head(uint64_t& n)
+    {
+        if (p == end)
+            fail(p, "truncated node");
+        uint8_t byte = *p++;
+        n = byte >> kind_bits;
+        if (n == head_max)
+            n += varint();
+        return static_cast<Kind>(byte & ((1 << kind_bits) - 1));
+    }
+
+    inline Slice Reader::bytes(uint64_t n)
+    {
+        if (n > static_cast<uint64_t>(end - p))
+            fail(p, "truncated atom");
+        Slice out(p, p + n);
+        p += n;
+        return out;
+    }
+} // namespace binary
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,201 @@
+#include "compact.hpp"
+//    compact.cpp - S-expressions in 16 bytes a node.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    static_assert(sizeof(CompactSExpr) == 16, "a CompactSExpr is two words");
+    static_assert(std::is_trivially_copyable<Symbol>::value, "a Symbol can be stored as bytes");
+
+    static uint32_t check_size(size_t size)
+    {
+        if (size > std::numeric_limits<uint32_t>::max())
+            throw std::length_error("too big for a CompactSExpr");
+        return size;
+    }
+
+    CompactSExpr::Block *CompactSExpr::make_block(size_t count, size_t size)
+    {
+        Block *b = static_cast<Block *>(::operator new(sizeof(Block) + size));
+        new (&b->refs) std::atomic<uint32_t>(1);
+        b->size = count;
+        return b;
+    }
+
+    void CompactSExpr::release()
+    {
+        if (!shared())
+            return;
+        Block *b = block();
+        bool is_list = tag == Tag::list;
+        tag = Tag::nil;
+        if (b->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        if (is_list)
+        {
+            CompactSExpr *items = reinterpret_cast<CompactSExpr *>(b->payload());
+            for (uint32_t i = 0; i < b->size; ++i)
+                items[i].~CompactSExpr();
+        }
+        ::operator delete(b);
+    }
+
+    void CompactSExpr::set_ref(Tag t, Slice s)
+    {
+        store<const char *>(0, s.begin());
+        store<uint32_t>(8, check_size(s.size()));
+        tag = t;
+    }
+
+    void CompactSExpr::set_string(const char *b, const char *e)
+    {
+        size_t size = e - b;
+        if (size <= inline_max)
+        {
+            memcpy(bytes, b, size);
+            length = size;
+            tag = Tag::short_string;
+            return;
+        }
+        Block *block = make_block(check_size(size), size);
+        memcpy(block->payload(), b, size);
+        store<Block *>(0, block);
+        tag = Tag::long_string;
+    }
+
+    template<class L>
+    void CompactSExpr::set_list(const L& items)
+    {
+        Block *block = make_block(0, check_size(items.size()) * sizeof(CompactSExpr));
+        CompactSExpr *out = reinterpret_cast<CompactSExpr *>(block->payload());
+        // the block only ever counts what has been constructed,
+        // so it can be released if an element throws
+        store<Block *>(0, block);
+        tag = Tag::list;
+        try
+        {
+            for (const auto& item : items)
+            {
+                new (&out[block->size]) CompactSExpr(item);
+                ++block->size;
+            }
+        }
+        catch (...)
+        {
+            release();
+            throw;
+        }
+    }
+
+    CompactSExpr::CompactSExpr(ListRef items)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {
+        set_list(items);
+    }
+
+    CompactSExpr::CompactSExpr(const List& items)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {
+        set_list(items);
+    }
+
+    class Pack
+    {
+        CompactSExpr *out;
+    public:
+        Pack(CompactSExpr *o)
+        : out(o)
+        {}
+
+        template<class A>
+        void operator () (const A& a)
+        {
+            *out = CompactSExpr(a);
+        }
+    };
+
+    CompactSExpr::CompactSExpr(const SExpr& sex)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {
+        apply(Void(), Pack(this), sex);
+    }
+
+    class Expand
+    {
+        const CompactSExpr *in;
+        SExpr *out;
+    public:
+        Expand(const CompactSExpr *i, SExpr *o)
+        : in(i)
+        , out(o)
+        {}
+
+        void operator () (Void)
+        {}
+        void operator () (ListRef items)
+        {
+            List l;
+            l.reserve(items.size());
+            for (const CompactSExpr& item : items)
+                l.emplace_back(item.expand());
+            *out = std::move(l);
+        }
+        void operator () (Int i)
+        {
+            *out = i;
+        }
+        void operator () (StringRef s)
+        {
+            // only borrowed if it was borrowed in the first place
+            if (in->is_borrowed())
+                *out = s;
+            else
+                *out = String(s.value.begin(), s.value.end());
+        }
+        void operator () (Token t)
+        {
+            *out = std::move(t);
+        }
+        void operator () (TokenRef t)
+        {
+            *out = t;
+        }
+    };
+
+    SExpr CompactSExpr::expand() const
+    {
+        SExpr out;
+        apply(Void(), Expand(this, &out), *this);
+        return out;
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,141 @@
+#ifndef TMWA_SEXPR_COMPACT_HPP
+#define TMWA_SEXPR_COMPACT_HPP
+//    compact.hpp - S-expressions in 16 bytes a node.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+
+#include <cstdint>
+#include <cstring>
+
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    class CompactSExpr;
+
+    /// The elements of a CompactSExpr list, which owns them.
+    class ListRef
+    {
+        const CompactSExpr *b, *e;
+    public:
+        ListRef(const CompactSExpr *begin = nullptr, const CompactSExpr *end = nullptr)
+        : b(begin)
+        , e(end)
+        {}
+        const CompactSExpr *begin() const { return b; }
+        const CompactSExpr *end() const { return e; }
+        size_t size() const;
+        bool empty() const { return b == e; }
+        const CompactSExpr& operator [](size_t i) const;
+    };
+
+    /// An immutable SExpr in 16 bytes, rather than sizeof(SExpr).
+    ///
+    /// Ints, tokens (which are interned anyway), borrowed atoms and
+    /// strings of up to 14 bytes are kept inline. The elements of a list,
+    /// and longer strings, are in a reference counted block that copies
+    /// share, so copying is O(1).
+    ///
+    /// apply, MATCH, is and get_if work as for SExpr, except that the
+    /// alternatives are views: a list is a ListRef and a String is a
+    /// StringRef, which point into the node, so must not outlive it.
+    class CompactSExpr : public PackedVariant<CompactSExpr, Void, ListRef, Int, StringRef, Token, TokenRef>
+    {
+        friend class VariantFriend;
+
+        enum class Tag : uint8_t
+        {
+            nil,
+            list,
+            integer,
+            short_string,
+            long_string,
+            string_ref,
+            token,
+            token_ref,
+        };
+        constexpr static size_t inline_max = 14;
+        // the header of a list's elements or a long string's bytes
+        struct Block
+        {
+            std::atomic<uint32_t> refs;
+            uint32_t size;
+
+            // the elements or bytes follow the header
+            char *payload() { return reinterpret_cast<char *>(this + 1); }
+        };
+
+        // for an int or a pointer: [0, 8), and a ref's size: [8, 12);
+        // for a short string: [0, inline_max) and its size in length
+        alignas(8) char bytes[inline_max];
+        uint8_t length;
+        Tag tag;
+
+        template<class W>
+        W load(size_t off) const;
+        template<class W>
+        void store(size_t off, W w);
+        Block *block() const;
+        bool shared() const;
+        void retain() const;
+        void release();
+        void set_ref(Tag t, Slice s);
+        void set_string(const char *b, const char *e);
+        template<class L>
+        void set_list(const L& items);
+        static Block *make_block(size_t count, size_t size);
+
+        size_t state() const;
+        template<class E>
+        E unpack() const;
+    public:
+        CompactSExpr(Void = Void());
+        CompactSExpr(Int i);
+        CompactSExpr(const String& s);
+        CompactSExpr(const Token& t);
+        CompactSExpr(StringRef s);
+        CompactSExpr(TokenRef t);
+        /// A list of copies of these.
+        explicit CompactSExpr(ListRef items);
+        /// A list of compact copies of these.
+        explicit CompactSExpr(const List& items);
+        /// Atoms that SExpr borrowed are borrowed here too.
+        explicit CompactSExpr(const SExpr& sex);
+
+        CompactSExpr(const CompactSExpr& r);
+        CompactSExpr(CompactSExpr&& r) noexcept;
+        CompactSExpr& operator = (const CompactSExpr& r);
+        CompactSExpr& operator = (CompactSExpr&& r) noexcept;
+        ~CompactSExpr();
+
+        /// Whether a string or token's bytes belong to someone else.
+        bool is_borrowed() const;
+
+        /// Back to an SExpr, e.g. to change it.
+        SExpr expand() const;
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#include "compact.tcc"
+
+#endif //TMWA_SEXPR_COMPACT_HPP
@@ -0,0 +1,218 @@
+//    compact.tcc - implementation of inlines and templates in compact.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cassert>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    inline size_t ListRef::size() const
+    {
+        return e - b;
+    }
+
+    inline const CompactSExpr& ListRef::operator [](size_t i) const
+    {
+        return b[i];
+    }
+
+    template<class W>
+    inline W CompactSExpr::load(size_t off) const
+    {
+        W w;
+        memcpy(&w, bytes + off, sizeof(w));
+        return w;
+    }
+
+    template<class W>
+    inline void CompactSExpr::store(size_t off, W w)
+    {
+        memcpy(bytes + off, &w, sizeof(w));
+    }
+
+    inline CompactSExpr::Block *CompactSExpr::block() const
+    {
+        return load<Block *>(0);
+    }
+
+    inline bool CompactSExpr::shared() const
+    {
+        return tag == Tag::list or tag == Tag::long_string;
+    }
+
+    inline void CompactSExpr::retain() const
+    {
+        if (shared())
+            block()->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    inline CompactSExpr::CompactSExpr(Void)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {}
+
+    inline CompactSExpr::CompactSExpr(Int i)
+    : bytes()
+    , length()
+    , tag(Tag::integer)
+    {
+        store<int64_t>(0, i.value);
+    }
+
+    inline CompactSExpr::CompactSExpr(const String& s)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {
+        set_string(s.value.data(), s.value.data() + s.value.size());
+    }
+
+    inline CompactSExpr::CompactSExpr(const Token& t)
+    : bytes()
+    , length()
+    , tag(Tag::token)
+    {
+        store<Symbol>(0, t.value);
+    }
+
+    inline CompactSExpr::CompactSExpr(StringRef s)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {
+        set_ref(Tag::string_ref, s.value);
+    }
+
+    inline CompactSExpr::CompactSExpr(TokenRef t)
+    : bytes()
+    , length()
+    , tag(Tag::nil)
+    {
+        set_ref(Tag::token_ref, t.value);
+    }
+
+    inline CompactSExpr::CompactSExpr(const CompactSExpr& r)
+    : length(r.length)
+    , tag(r.tag)
+    {
+        memcpy(bytes, r.bytes, sizeof(bytes));
+        retain();
+    }
+
+    inline CompactSExpr::CompactSExpr(CompactSExpr&& r) noexcept
+    : length(r.length)
+    , tag(r.tag)
+    {
+        memcpy(bytes, r.bytes, sizeof(bytes));
+        r.tag = Tag::nil;
+    }
+
+    inline CompactSExpr& CompactSExpr::operator = (const CompactSExpr& r)
+    {
+        // r may be one of our own elements, so copy it before releasing
+        return *this = CompactSExpr(r);
+    }
+
+    inline CompactSExpr& CompactSExpr::operator = (CompactSExpr&& r) noexcept
+    {
+        // likewise, take r over before release() can free the block it is in
+        char taken[sizeof(bytes)];
+        memcpy(taken, r.bytes, sizeof(bytes));
+        uint8_t taken_length = r.length;
+        Tag taken_tag = r.tag;
+        r.tag = Tag::nil;
+        release();
+        memcpy(bytes, taken, sizeof(bytes));
+        length = taken_length;
+        tag = taken_tag;
+        return *this;
+    }
+
+    inline CompactSExpr::~CompactSExpr()
+    {
+        release();
+    }
+
+    inline bool CompactSExpr::is_borrowed() const
+    {
+        return tag == Tag::string_ref or tag == Tag::token_ref;
+    }
+
+    inline size_t CompactSExpr::state() const
+    {
+        constexpr static uint8_t states[] = { 0, 1, 2, 3, 3, 3, 4, 5 };
+        return states[static_cast<uint8_t>(tag)];
+    }
+
+    template<>
+    inline Void CompactSExpr::unpack<Void>() const
+    {
+        return Void();
+    }
+
+    template<>
+    inline ListRef CompactSExpr::unpack<ListRef>() const
+    {
+        Block *b = block();
+        const CompactSExpr *items = reinterpret_cast<const CompactSExpr *>(b->payload());
+        return ListRef(items, items + b->size);
+    }
+
+    template<>
+    inline Int CompactSExpr::unpack<Int>() const
+    {
+        return Int(load<int64_t>(0));
+    }
+
+    template<>
+    inline StringRef CompactSExpr::unpack<StringRef>() const
+    {
+        switch (tag)
+        {
+        case Tag::short_string:
+            return StringRef(Slice(bytes, bytes + length));
+        case Tag::long_string:
+        {
+            Block *b = block();
+            const char *text = b->payload();
+            return StringRef(Slice(text, text + b->size));
+        }
+        default:
+            assert(tag == Tag::string_ref);
+            const char *text = load<const char *>(0);
+            return StringRef(Slice(text, text + load<uint32_t>(8)));
+        }
+    }
+
+    template<>
+    inline Token CompactSExpr::unpack<Token>() const
+    {
+        return Token(load<Symbol>(0));
+    }
+
+    template<>
+    inline TokenRef CompactSExpr::unpack<TokenRef>() const
+    {
+        const char *text = load<const char *>(0);
+        return TokenRef(Slice(text, text + load<uint32_t>(8)));
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,118 @@
+#ifndef TMWA_SEXPR_COWQ_HPP
+#define TMWA_SEXPR_COWQ_HPP
+//    cowq.hpp - Appendable contiguous queue that shares its elements.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relocate.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    // like vq, but copies share the elements (as long as the allocator
+    // would be the same), and each is a view of part of them, so copying
+    // and take_front are O(1). Anything that could change an element
+    // first makes sure it is the only one that can see it (copy-on-write).
+    template<class T, class A = std::allocator<T>>
+    class cowq
+    {
+        struct Block
+        {
+            std::atomic<size_t> refs;
+            // [0, used) are constructed, out of room for cap,
+            // and stay so until the last owner lets go
+            uint32_t used, cap;
+
+            T *items() { return reinterpret_cast<T *>(this + 1); }
+        };
+        typedef typename std::allocator_traits<A>::template rebind_alloc<Block> BlockAlloc;
+
+        A alloc;
+        Block *block;
+        // this queue is [head, tail) of the block's elements
+        uint32_t head, tail;
+
+        static size_t slots(size_t cap);
+        void drop();
+        bool unique() const;
+        void reallocate(size_t cap);
+        void make_room();
+    public:
+        cowq() : alloc(), block(), head(), tail() {}
+        explicit cowq(const A& a) : alloc(a), block(), head(), tail() {}
+        // a copy always uses a default-constructed allocator,
+        // so only shares with the original if that's what it used
+        cowq(const cowq&);
+        cowq(cowq&&) noexcept;
+        cowq& operator = (cowq) noexcept;
+        ~cowq();
+        template<class It>
+        cowq(It b, It e);
+        cowq(std::initializer_list<T> l);
+
+        explicit operator bool() const { return head != tail; }
+        bool empty() const { return head == tail; }
+        size_t size() const { return tail - head; }
+        void reserve(size_t n);
+        /// The copy-on-write path: if the elements are shared, take
+        /// a copy of them. Everything that gives out a mutable reference
+        /// calls this first.
+        void detach();
+
+        T& operator [](size_t i) { detach(); return block->items()[head + i]; }
+        const T& operator [](size_t i) const { return block->items()[head + i]; }
+        T& front() { return (*this)[0]; }
+        const T& front() const { return (*this)[0]; }
+        T& back() { return (*this)[size() - 1]; }
+        const T& back() const { return (*this)[size() - 1]; }
+
+        /// Moves the element out if it isn't shared, else copies it.
+        T take_front();
+        void pop_front() { ++head; }
+        void push_back(T v);
+        template<class... Args>
+        void emplace_back(Args&&... args);
+
+        typedef T *iterator;
+        typedef const T *const_iterator;
+
+        iterator begin() { detach(); return block ? block->items() + head : nullptr; }
+        iterator end() { detach(); return block ? block->items() + tail : nullptr; }
+        const_iterator begin() const { return block ? block->items() + head : nullptr; }
+        const_iterator end() const { return block ? block->items() + tail : nullptr; }
+    };
+
+    // owns nothing inside itself
+    template<class T, class A>
+    struct is_trivially_relocatable<cowq<T, A>>
+    : std::integral_constant<bool, std::is_empty<A>::value or is_trivially_relocatable<A>::value>
+    {};
+} // namespace sexpr
+} // namespace tmwa
+
+#include "cowq.tcc"
+
+#endif //TMWA_SEXPR_COWQ_HPP
@@ -0,0 +1,225 @@
+//    cowq.tcc - implementation of inlines and templates in cowq.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    template<class T, class A>
+    size_t cowq<T, A>::slots(size_t cap)
+    {
+        static_assert(alignof(T) <= alignof(Block), "elements follow the header");
+        return 1 + (cap * sizeof(T) + sizeof(Block) - 1) / sizeof(Block);
+    }
+
+    template<class T, class A>
+    bool cowq<T, A>::unique() const
+    {
+        return block->refs.load(std::memory_order_acquire) == 1;
+    }
+
+    template<class T, class A>
+    void cowq<T, A>::drop()
+    {
+        if (block and block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            T *items = block->items();
+            for (uint32_t i = 0; i != block->used; ++i)
+                items[i].~T();
+            size_t n = slots(block->cap);
+            block->~Block();
+            BlockAlloc(alloc).deallocate(block, n);
+        }
+        block = nullptr;
+        head = tail = 0;
+    }
+
+    /// Become the only owner of a new block with room for cap,
+    /// moving the elements if this was already their only owner.
+    template<class T, class A>
+    void cowq<T, A>::reallocate(size_t cap)
+    {
+        if (cap > UINT32_MAX)
+            throw std::length_error("cowq too long");
+        Block *fresh = BlockAlloc(alloc).allocate(slots(cap));
+        new (fresh) Block();
+        fresh->refs.store(1, std::memory_order_relaxed);
+        fresh->used = 0;
+        fresh->cap = cap;
+        if (block)
+        {
+            T *src = block->items(), *dst = fresh->items();
+            if (unique())
+            {
+                // what the old block still holds is just bytes
+                for (uint32_t i = 0; i != head; ++i)
+                    src[i].~T();
+                for (uint32_t i = tail; i != block->used; ++i)
+                    src[i].~T();
+                relocate(src + head, src + tail, dst);
+                fresh->used = tail - head;
+                block->used = 0;
+            }
+            else
+            {
+                for (uint32_t i = head; i != tail; ++i)
+                {
+                    new (dst + fresh->used) T(src[i]);
+                    ++fresh->used;
+                }
+            }
+        }
+        uint32_t count = fresh->used;
+        drop();
+        block = fresh;
+        head = 0;
+        tail = count;
+    }
+
+    template<class T, class A>
+    void cowq<T, A>::make_room()
+    {
+        // appending in place is only allowed to the only owner,
+        // if nothing was ever constructed after the end
+        if (!block or !unique() or tail != block->used or block->used == block->cap)
+            // most lists are short, so start with room for a few
+            reallocate(std::max<size_t>(4, size_t(tail - head) * 2));
+    }
+
+    template<class T, class A>
+    cowq<T, A>::cowq(const cowq& r)
+    : alloc(std::allocator_traits<A>::select_on_container_copy_construction(r.alloc))
+    , block()
+    , head()
+    , tail()
+    {
+        if (r.head == r.tail)
+            return;
+        if (alloc == r.alloc)
+        {
+            block = r.block;
+            head = r.head;
+            tail = r.tail;
+            block->refs.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        reserve(r.size());
+        for (const T& v : r)
+            emplace_back(v);
+    }
+
+    template<class T, class A>
+    cowq<T, A>::cowq(cowq&& r) noexcept
+    : alloc(std::move(r.alloc)), block(r.block), head(r.head), tail(r.tail)
+    {
+        r.block = nullptr;
+        r.head = r.tail = 0;
+    }
+
+    template<class T, class A>
+    cowq<T, A>& cowq<T, A>::operator = (cowq r) noexcept
+    {
+        drop();
+        alloc = std::move(r.alloc);
+        block = r.block;
+        head = r.head;
+        tail = r.tail;
+        r.block = nullptr;
+        r.head = r.tail = 0;
+        return *this;
+    }
+
+    template<class T, class A>
+    cowq<T, A>::~cowq()
+    {
+        drop();
+    }
+
+    template<class T, class A>
+    template<class It>
+    cowq<T, A>::cowq(It b, It e)
+    : alloc(), block(), head(), tail()
+    {
+        for (; b != e; ++b)
+            push_back(*b);
+    }
+
+    template<class T, class A>
+    cowq<T, A>::cowq(std::initializer_list<T> l)
+    : alloc(), block(), head(), tail()
+    {
+        reserve(l.size());
+        for (const T& v : l)
+            emplace_back(v);
+    }
+
+    template<class T, class A>
+    void cowq<T, A>::reserve(size_t n)
+    {
+        if (block and unique() and tail == block->used and n <= size_t(block->cap - head))
+            return;
+        reallocate(std::max(n, size()));
+    }
+
+    template<class T, class A>
+    void cowq<T, A>::detach()
+    {
+        if (block and !unique())
+        {
+            if (head == tail)
+                drop();
+            else
+                reallocate(tail - head);
+        }
+    }
+
+    template<class T, class A>
+    T cowq<T, A>::take_front()
+    {
+        T& old_front = block->items()[head++];
+        if (unique())
+            return std::move(old_front);
+        return old_front;
+    }
+
+    template<class T, class A>
+    void cowq<T, A>::push_back(T v)
+    {
+        make_room();
+        new (block->items() + block->used) T(std::move(v));
+        ++block->used;
+        ++tail;
+    }
+
+    template<class T, class A>
+    template<class... Args>
+    void cowq<T, A>::emplace_back(Args&&... args)
+    {
+        make_room();
+        new (block->items() + block->used) T(std::forward<Args>(args)...);
+        ++block->used;
+        ++tail;
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,50 @@
+#include "document.hpp"
+//    document.cpp - A whole input, parsed into one arena.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <new>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    Document::Document(TrackingStream in, Atoms atoms)
+    : arena()
+    , list()
+    {
+        void *where = arena->allocate(sizeof(List), alignof(List));
+        list = new (where) List(ArenaAllocator<SExpr>(&*arena));
+        // if this throws, the partial lists are dropped with the arena
+        Parser parser(std::move(in), atoms);
+        parser.use_arena(&*arena);
+        for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+            list->push_back(std::move(sex));
+    }
+
+    const List& Document::forms() const
+    {
+        return *list;
+    }
+
+    size_t Document::bytes() const
+    {
+        return arena->bytes();
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,56 @@
+#ifndef TMWA_SEXPR_DOCUMENT_HPP
+#define TMWA_SEXPR_DOCUMENT_HPP
+//    document.hpp - A whole input, parsed into one arena.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "arena.hpp"
+#include "parser.hpp"
+#include "ptr.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Every form of an input, with all of its lists and copied atoms
+    /// in one Arena. Dropping it frees a few chunks, instead of every
+    /// node: nothing in it is ever destroyed one by one.
+    ///
+    /// With Atoms::borrow, atoms may point into the input buffer,
+    /// which must then outlive the Document.
+    class Document
+    {
+        Unique<Arena> arena;
+        // lives in the arena too
+        List *list;
+    public:
+        explicit Document(TrackingStream in, Atoms atoms = Atoms::copy);
+        Document(Document&&) = default;
+
+        /// Read-only, so that nothing can put heap memory in it.
+        /// (Copies are ordinary heap lists.)
+        const List& forms() const;
+        /// How much of the arena is used.
+        size_t bytes() const;
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_DOCUMENT_HPP
@@ -0,0 +1,121 @@
+#include "events.hpp"
+//    events.cpp - Parse S-expressions into callbacks, without building trees.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+namespace tmwa
+{
+namespace sexpr
+{
+    EventHandler::~EventHandler() = default;
+
+    Flow EventHandler::begin_list(Position)
+    {
+        return Flow::proceed;
+    }
+
+    Flow EventHandler::end_list(Position)
+    {
+        return Flow::proceed;
+    }
+
+    Flow EventHandler::atom_int(Position, int64_t)
+    {
+        return Flow::proceed;
+    }
+
+    Flow EventHandler::atom_string(Position, Slice)
+    {
+        return Flow::proceed;
+    }
+
+    Flow EventHandler::atom_token(Position, Slice)
+    {
+        return Flow::proceed;
+    }
+
+    /// Turns one lexeme into one event.
+    class Dispatch
+    {
+        EventHandler *handler;
+        Position pos;
+        size_t *open;
+    public:
+        Dispatch(EventHandler *h, Position p, size_t *o)
+        : handler(h)
+        , pos(p)
+        , open(o)
+        {}
+
+        Flow operator () (EndOfStream)
+        {
+            return Flow::stop;
+        }
+        Flow operator () (BeginList)
+        {
+            ++*open;
+            return handler->begin_list(pos);
+        }
+        Flow operator () (EndList)
+        {
+            --*open;
+            return handler->end_list(pos);
+        }
+        Flow operator () (const Int& i)
+        {
+            return handler->atom_int(pos, i.value);
+        }
+        Flow operator () (const String& s)
+        {
+            return handler->atom_string(pos, Slice(s.value.data(), s.value.data() + s.value.size()));
+        }
+        Flow operator () (const StringRef& s)
+        {
+            return handler->atom_string(pos, s.value);
+        }
+        Flow operator () (const Token& t)
+        {
+            return handler->atom_token(pos, Slice(t.value.begin(), t.value.end()));
+        }
+        Flow operator () (const TokenRef& t)
+        {
+            return handler->atom_token(pos, t.value);
+        }
+    };
+
+    bool EventParser::run(EventHandler& handler)
+    {
+        while (true)
+        {
+            Lexeme lexeme = lexer.next();
+            if (lexeme.is<EndOfStream>())
+                return true;
+            Flow flow;
+            apply(flow, Dispatch(&handler, lexer.position(), &open), lexeme);
+            if (flow == Flow::stop)
+                return false;
+            if (flow == Flow::skip and open)
+            {
+                lexer.skip_list();
+                --open;
+            }
+        }
+    }
+} // namespace sexpr
+} // namespace tmwa
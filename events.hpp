@@ -0,0 +1,85 @@
+#ifndef TMWA_SEXPR_EVENTS_HPP
+#define TMWA_SEXPR_EVENTS_HPP
+//    events.hpp - Parse S-expressions into callbacks, without building trees.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <cstdint>
+
+#include "parser.hpp"
+#include "sexpr.hpp"
+#include "tracking_stream.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// What to do after an event.
+    enum class Flow
+    {
+        proceed,
+        /// Don't report the rest of the innermost open list, nor its end;
+        /// from begin_list, that is the list just begun. The lexer
+        /// skips over it without lexing it (see Lexer::skip_list).
+        /// At the top level, the same as proceed.
+        skip,
+        /// Return from EventParser::run, which may be called again
+        /// to carry on.
+        stop,
+    };
+
+    /// Override the events that are wanted; the rest just proceed.
+    ///
+    /// pos is where the lexeme began. Atoms are unescaped, and only
+    /// valid during the call.
+    class EventHandler
+    {
+    public:
+        virtual ~EventHandler();
+
+        virtual Flow begin_list(Position pos);
+        virtual Flow end_list(Position pos);
+        virtual Flow atom_int(Position pos, int64_t v);
+        virtual Flow atom_string(Position pos, Slice s);
+        virtual Flow atom_token(Position pos, Slice t);
+    };
+
+    /// Drives an EventHandler straight from the Lexer, so that no
+    /// lists are ever built, and atoms are only copied if they must be
+    /// (i.e. not from a buffer that outlives the parser).
+    class EventParser
+    {
+        Lexer lexer;
+        // lists begun and not ended or skipped
+        size_t open;
+    public:
+        EventParser(TrackingStream in)
+        : lexer(std::move(in), Atoms::borrow)
+        , open()
+        {}
+
+        void limit_depth(size_t n) { lexer.limit_depth(n); }
+        /// Report events until the end of the input, and return true,
+        /// or until a handler says Flow::stop, and return false.
+        bool run(EventHandler& handler);
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_EVENTS_HPP
@@ -28,17 +28,19 @@ namespace sexpr
 {
     // a forward_list stores only the front "pointer"
     // this wrapper stores the back "pointer" as well
-    template<class T>
+    template<class T, class A = std::allocator<T>>
     class flq
     {
-        typedef std::forward_list<T> _list;
+        typedef std::forward_list<T, A> _list;
         typedef typename _list::iterator _iterator;
         _list impl;
         _iterator last;
     public:
         flq() : impl(), last(impl.before_begin()) {}
+        explicit flq(const A& alloc) : impl(alloc), last(impl.before_begin()) {}
         // copy/move construct and assign are NOT quite fine, but destruct is (of course)
-        flq(flq&&);
+        // (a copy always uses a default-constructed allocator)
+        flq(flq&&) noexcept;
         flq(const flq&);
         flq& operator = (flq);
         template<class It>
@@ -65,8 +67,8 @@ namespace sexpr
         T& back();
         const T& back() const;
         void push_back(T v);
-        template<class... A>
-        void emplace_back(A&&... a);
+        template<class... Args>
+        void emplace_back(Args&&... args);
 
         class iterator;
         class const_iterator;
@@ -77,8 +79,8 @@ namespace sexpr
         const_iterator end() const;
     };
 
-    template<class T>
-    flq<T>::flq(flq&& r)
+    template<class T, class A>
+    flq<T, A>::flq(flq&& r) noexcept
     : impl(std::move(r.impl))
     , last(r.last)
     {
@@ -86,15 +88,15 @@ namespace sexpr
             last = impl.before_begin();
     }
 
-    template<class T>
-    flq<T>::flq(const flq& r) : impl(), last(impl.before_begin())
+    template<class T, class A>
+    flq<T, A>::flq(const flq& r) : impl(), last(impl.before_begin())
     {
         for (auto b = r.begin(), e = r.end(); b != e; ++b)
             push_back(*b);
     }
 
-    template<class T>
-    flq<T>& flq<T>::operator = (flq<T> r)
+    template<class T, class A>
+    flq<T, A>& flq<T, A>::operator = (flq<T, A> r)
     {
         impl = std::move(r.impl);
         last = r.last;
@@ -103,14 +105,14 @@ namespace sexpr
         return *this;
     }
 
-    template<class T>
-    class flq<T>::iterator
+    template<class T, class A>
+    class flq<T, A>::iterator
     {
-        typedef std::forward_list<T> _list;
+        typedef std::forward_list<T, A> _list;
         typedef typename _list::iterator _iterator;
         _iterator impl;
 
-        friend class flq<T>::const_iterator;
+        friend class flq<T, A>::const_iterator;
     public:
         iterator() : impl() {}
         iterator(_iterator it) : impl(it) {}
@@ -155,14 +157,14 @@ namespace sexpr
         }
     };
 
-    template<class T>
-    class flq<T>::const_iterator
+    template<class T, class A>
+    class flq<T, A>::const_iterator
     {
-        typedef std::forward_list<T> _list;
+        typedef std::forward_list<T, A> _list;
         typedef typename _list::iterator _iterator;
         typedef typename _list::const_iterator _const_iterator;
         _const_iterator impl;
-        typedef typename flq<T>::iterator iterator;
+        typedef typename flq<T, A>::iterator iterator;
     public:
         const_iterator() : impl() {}
         const_iterator(iterator it) : impl(it.impl) {}
@@ -23,40 +23,40 @@ namespace tmwa
 {
 namespace sexpr
 {
-    template<class T>
-    flq<T>::operator bool()
+    template<class T, class A>
+    flq<T, A>::operator bool()
     {
         return !impl.empty();
     }
 
-    template<class T>
-    bool flq<T>::empty()
+    template<class T, class A>
+    bool flq<T, A>::empty()
     {
         return impl.empty();
     }
 
-    template<class T>
-    T& flq<T>::front()
+    template<class T, class A>
+    T& flq<T, A>::front()
     {
         return impl.front();
     }
 
-    template<class T>
-    const T& flq<T>::front() const
+    template<class T, class A>
+    const T& flq<T, A>::front() const
     {
         return impl.front();
     }
 
-    template<class T>
-    T flq<T>::take_front()
+    template<class T, class A>
+    T flq<T, A>::take_front()
     {
         T old_front = std::move(impl.front());
         pop_front();
         return old_front;
     }
 
-    template<class T>
-    void flq<T>::pop_front()
+    template<class T, class A>
+    void flq<T, A>::pop_front()
     {
         impl.pop_front();
         if (impl.empty())
@@ -64,51 +64,51 @@ namespace sexpr
             last = impl.before_begin();
     }
 
-    template<class T>
-    T& flq<T>::back()
+    template<class T, class A>
+    T& flq<T, A>::back()
     {
         return *last;
     }
 
-    template<class T>
-    const T& flq<T>::back() const
+    template<class T, class A>
+    const T& flq<T, A>::back() const
     {
         return *last;
     }
 
-    template<class T>
-    void flq<T>::push_back(T v)
+    template<class T, class A>
+    void flq<T, A>::push_back(T v)
     {
         last = impl.insert_after(last, std::move(v));
     }
 
-    template<class T>
-    template<class... A>
-    void flq<T>::emplace_back(A&&... a)
+    template<class T, class A>
+    template<class... Args>
+    void flq<T, A>::emplace_back(Args&&... args)
     {
-        last = impl.emplace_after(last, std::forward<A>(a)...);
+        last = impl.emplace_after(last, std::forward<Args>(args)...);
     }
 
-    template<class T>
-    typename flq<T>::iterator flq<T>::begin()
+    template<class T, class A>
+    typename flq<T, A>::iterator flq<T, A>::begin()
     {
         return impl.before_begin();
     }
 
-    template<class T>
-    typename flq<T>::iterator flq<T>::end()
+    template<class T, class A>
+    typename flq<T, A>::iterator flq<T, A>::end()
     {
         return last;
     }
 
-    template<class T>
-    typename flq<T>::const_iterator flq<T>::begin() const
+    template<class T, class A>
+    typename flq<T, A>::const_iterator flq<T, A>::begin() const
     {
         return impl.before_begin();
     }
 
-    template<class T>
-    typename flq<T>::const_iterator flq<T>::end() const
+    template<class T, class A>
+    typename flq<T, A>::const_iterator flq<T, A>::end() const
     {
         return last;
     }
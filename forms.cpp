@@ -0,0 +1,117 @@
+#include "forms.hpp"
+//    forms.cpp - Find where top-level forms end, without parsing them.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "scan.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    FormScanner::FormScanner()
+    : depth(0)
+    , in_token(false)
+    , in_string(false)
+    , escaped(false)
+    {}
+
+    FormScanner::FormScanner(size_t open)
+    : depth(open)
+    , in_token(false)
+    , in_string(false)
+    , escaped(false)
+    {}
+
+    const char *FormScanner::scan(const char *p, const char *e)
+    {
+        while (p != e)
+        {
+            if (escaped)
+            {
+                // whatever it is, it's part of the current atom
+                // (the rest of a \x or octal escape is never special)
+                escaped = false;
+                ++p;
+                continue;
+            }
+            if (in_string)
+            {
+                p = sexpr::scan.find_string_end(p, e);
+                if (p == e)
+                    break;
+                if (*p++ == '\\')
+                {
+                    escaped = true;
+                    continue;
+                }
+                in_string = false;
+                if (!depth)
+                    return p;
+                continue;
+            }
+            if (in_token)
+            {
+                p = sexpr::scan.find_token_end(p, e);
+                if (p == e)
+                    break;
+                if (*p == '\\')
+                {
+                    escaped = true;
+                    ++p;
+                    continue;
+                }
+                in_token = false;
+                if (!depth)
+                    return p;
+            }
+            p = sexpr::scan.skip_blanks(p, e);
+            if (p == e)
+                break;
+            switch (*p++)
+            {
+            case '(':
+                ++depth;
+                break;
+            case ')':
+                if (!depth)
+                    return p;
+                if (!--depth)
+                    return p;
+                break;
+            case '"':
+                in_string = true;
+                break;
+            case '\\':
+                in_token = true;
+                escaped = true;
+                break;
+            default:
+                in_token = true;
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    bool FormScanner::busy() const
+    {
+        return depth or in_token or in_string or escaped;
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,57 @@
+#ifndef TMWA_SEXPR_FORMS_HPP
+#define TMWA_SEXPR_FORMS_HPP
+//    forms.hpp - Find where top-level forms end, without parsing them.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cstddef>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Knows just enough of the syntax to not be fooled by parentheses
+    /// in strings or after backslashes. Everything else, including
+    /// reporting errors, is left to the Lexer that parses the form later.
+    ///
+    /// The state is kept between calls, so input may arrive in pieces.
+    class FormScanner
+    {
+        size_t depth;
+        bool in_token, in_string, escaped;
+    public:
+        FormScanner();
+        /// As if the input began with that many '('.
+        explicit FormScanner(size_t open);
+
+        /// Continue scanning at b, which is where the last call stopped.
+        /// Returns the end of the first top-level form that ends in
+        /// [b, e), or nullptr if none does.
+        ///
+        /// A top-level token ends before the character that ends it,
+        /// so it is not known to have ended until that is seen.
+        /// An unmatched ')' counts as a form, so the Lexer can complain.
+        const char *scan(const char *b, const char *e);
+
+        /// Whether a form has started but not ended.
+        bool busy() const;
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_FORMS_HPP
@@ -18,6 +18,16 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <system_error>
+
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "scan.hpp"
+
 namespace tmwa
 {
 namespace sexpr
@@ -69,54 +79,249 @@ namespace sexpr
         return escape_tables[for_string][c];
     }
 
+    constexpr size_t Printer::block_size;
+
+    Printer::Printer(int f)
+    : buf()
+    , used()
+    , fd(f)
+    , os()
+    {}
+
+    Printer::Printer(std::ostream& o)
+    : buf()
+    , used()
+    , fd(-1)
+    , os(&o)
+    {}
+
+    Printer::~Printer()
+    {
+        try
+        {
+            flush();
+        }
+        catch (const std::system_error&)
+        {
+        }
+    }
+
+    char *Printer::room(size_t n)
+    {
+        if (used + n > buf.size())
+        {
+            // full-sized, so write it out rather than growing
+            if (buf.size() >= block_size)
+                flush();
+            if (used + n > buf.size())
+                buf.resize(std::max(used + n, std::min(std::max<size_t>(2 * buf.size(), 256), block_size)));
+        }
+        return buf.data() + used;
+    }
+
+    void Printer::flush()
+    {
+        const char *p = buf.data(), *e = p + used;
+        used = 0;
+        if (os)
+        {
+            os->write(p, e - p);
+            return;
+        }
+        while (p != e)
+        {
+            ssize_t n = write(fd, p, e - p);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error(errno, std::generic_category(), "write");
+            }
+            p += n;
+        }
+    }
+
+    void Printer::put(char c)
+    {
+        *room(1) = c;
+        ++used;
+    }
+
+    void Printer::put(const char *b, const char *e)
+    {
+        memcpy(room(e - b), b, e - b);
+        used += e - b;
+    }
+
+    // two digits at a time
+    static const char digit_pairs[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+    void Printer::put_int(int64_t v)
+    {
+        char tmp[20];
+        char *e = tmp + sizeof(tmp), *p = e;
+        // negating the unsigned value works for INT64_MIN too
+        uint64_t u = v < 0 ? -static_cast<uint64_t>(v) : v;
+        while (u >= 100)
+        {
+            p -= 2;
+            memcpy(p, digit_pairs + 2 * (u % 100), 2);
+            u /= 100;
+        }
+        if (u >= 10)
+        {
+            p -= 2;
+            memcpy(p, digit_pairs + 2 * u, 2);
+        }
+        else
+            *--p = '0' + u;
+        if (v < 0)
+            *--p = '-';
+        put(p, e);
+    }
+
+    void Printer::put_escaped(const char *b, const char *e, bool for_string)
+    {
+        auto find = for_string ? scan.find_string_escape : scan.find_token_escape;
+        while (b != e)
+        {
+            const char *run = find(b, e);
+            put(b, run);
+            if (run == e)
+                break;
+            const char *esc = escape(*run, for_string);
+            put(esc, esc + strlen(esc));
+            b = run + 1;
+        }
+    }
+
+    void Printer::put_string(const char *b, const char *e)
+    {
+        put('"');
+        put_escaped(b, e, true);
+        put('"');
+    }
+
+    void Printer::put_token(const char *b, const char *e)
+    {
+        put_escaped(b, e, false);
+    }
+
     class Print
     {
-        std::ostream *out;
+        Printer *out;
     public:
-        Print(std::ostream *o)
+        bool ok;
+
+        Print(Printer *o)
         : out(o)
+        , ok(true)
         {}
 
         void operator () (Void)
         {
-            // misleading function name - actually sets badbit
-            out->clear(std::ios_base::badbit);
+            ok = false;
         }
         void operator () (const List& l)
         {
-            *out << '(';
+            out->put('(');
             bool first = true;
             for (const SExpr& sex : l)
             {
                 if (first)
                     first = false;
                 else
-                    *out << ' ';
-                apply(Void(), *this, sex);
+                    out->put(' ');
+                // sublists directly, to save stack on deep trees
+                if (auto sub = sex.get_if<List>())
+                    (*this)(*sub);
+                else
+                    apply(Void(), *this, sex);
+            }
+            out->put(')');
+        }
+        void operator () (const ListRef& l)
+        {
+            out->put('(');
+            bool first = true;
+            for (const CompactSExpr& sex : l)
+            {
+                if (first)
+                    first = false;
+                else
+                    out->put(' ');
+                // sublists directly, to save stack on deep trees
+                if (auto sub = sex.get_if<ListRef>())
+                    (*this)(*sub);
+                else
+                    apply(Void(), *this, sex);
             }
-            *out << ')';
+            out->put(')');
         }
         void operator () (const Int& i)
         {
-            *out << i.value;
+            out->put_int(i.value);
         }
         void operator () (const String& s)
         {
-            *out << '"';
-            for (char c : s.value)
-                *out << escape(c, true);
-            *out << '"';
+            out->put_string(s.value.data(), s.value.data() + s.value.size());
         }
         void operator () (const Token& t)
         {
-            for (char c : t.value)
-                *out << escape(c, false);
+            out->put_token(t.value.begin(), t.value.end());
+        }
+        void operator () (const StringRef& s)
+        {
+            out->put_string(s.value.begin(), s.value.end());
+        }
+        void operator () (const TokenRef& t)
+        {
+            out->put_token(t.value.begin(), t.value.end());
         }
     };
 
+    bool Printer::print(const SExpr& sex)
+    {
+        Print print(this);
+        apply(Void(), print, sex);
+        return print.ok;
+    }
+
+    bool Printer::print(const CompactSExpr& sex)
+    {
+        Print print(this);
+        apply(Void(), print, sex);
+        return print.ok;
+    }
+
     std::ostream& operator << (std::ostream& os, const SExpr& sex)
     {
-        apply(Void(), Print(&os), sex);
+        Printer out(os);
+        bool ok = out.print(sex);
+        out.flush();
+        if (!ok)
+            // misleading function name - actually sets badbit
+            os.clear(std::ios_base::badbit);
+        return os;
+    }
+
+    std::ostream& operator << (std::ostream& os, const CompactSExpr& sex)
+    {
+        Printer out(os);
+        bool ok = out.print(sex);
+        out.flush();
+        if (!ok)
+            os.clear(std::ios_base::badbit);
         return os;
     }
 } // namespace sexpr
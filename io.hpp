@@ -20,14 +20,61 @@
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <ostream>
+#include <vector>
 
+#include <cstdint>
+
+#include "compact.hpp"
 #include "sexpr.hpp"
 
 namespace tmwa
 {
 namespace sexpr
 {
+    /// Prints into a buffer, and writes it out in large blocks.
+    /// Runs of characters that need no escaping are copied whole.
+    ///
+    /// With a file descriptor, write errors are thrown as
+    /// std::system_error; with an ostream, they set its state.
+    class Printer
+    {
+        std::vector<char> buf;
+        size_t used;
+        int fd;
+        std::ostream *os;
+
+        char *room(size_t n);
+        void put_escaped(const char *b, const char *e, bool for_string);
+    public:
+        static constexpr size_t block_size = 64 * 1024;
+
+        /// fd is not closed.
+        explicit Printer(int fd);
+        explicit Printer(std::ostream& os);
+        Printer(const Printer&) = delete;
+        Printer& operator = (const Printer&) = delete;
+        /// Flushes, ignoring errors, since it may run while an exception
+        /// unwinds; call flush() first to find out about them.
+        ~Printer();
+
+        /// Returns false if there was a Void, which has no text form.
+        bool print(const SExpr& sex);
+        bool print(const CompactSExpr& sex);
+
+        /// Exactly these bytes.
+        void put(char c);
+        void put(const char *b, const char *e);
+        void put_int(int64_t v);
+        /// With quotes and escapes.
+        void put_string(const char *b, const char *e);
+        /// With escapes.
+        void put_token(const char *b, const char *e);
+
+        void flush();
+    };
+
     std::ostream& operator << (std::ostream&, const SExpr&);
+    std::ostream& operator << (std::ostream&, const CompactSExpr&);
 #if 0
     std::istream& operator >> (std::istream&, SExpr&);
 #endif
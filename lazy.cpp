@@ -0,0 +1,273 @@
+#include "lazy.hpp"
+//    lazy.cpp - Parse only the lists of a file that are looked at.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "parser.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    bool stamp_file(const std::string& filename, FileStamp& out)
+    {
+        struct stat st;
+        if (stat(filename.c_str(), &st) == -1)
+            return false;
+        out.size = st.st_size;
+        out.mtime_sec = st.st_mtim.tv_sec;
+        out.mtime_nsec = st.st_mtim.tv_nsec;
+        return true;
+    }
+
+    static bool operator == (const FileStamp& l, const FileStamp& r)
+    {
+        return l.size == r.size and l.mtime_sec == r.mtime_sec and l.mtime_nsec == r.mtime_nsec;
+    }
+
+    struct IndexHeader
+    {
+        char magic[8];
+        FileStamp stamp;
+        uint64_t count;
+    };
+    constexpr static char index_magic[8] = {'\0', 's', 'x', 'i', 'd', 'x', '\1', '\0'};
+
+    ParenIndex::ParenIndex()
+    : built()
+    , map()
+    , entries()
+    , count()
+    {}
+
+    ParenIndex ParenIndex::build(const std::string& name, const char *b, const char *e)
+    {
+        ParenIndex out;
+        // the entries of the lists that haven't ended yet
+        std::vector<size_t> open;
+        Lexer lexer(TrackingStream(name, b, e), Atoms::borrow);
+        for (Lexeme lexeme = lexer.next(); !lexeme.is<EndOfStream>(); lexeme = lexer.next())
+        {
+            // the Lexer balances the parentheses for us
+            if (lexeme.is<BeginList>())
+            {
+                open.push_back(out.built.size());
+                out.built.push_back(Entry{lexer.position().offset, 0, 0});
+            }
+            else if (lexeme.is<EndList>())
+            {
+                Entry& entry = out.built[open.back()];
+                entry.close = lexer.position().offset;
+                entry.lists = out.built.size() - open.back() - 1;
+                open.pop_back();
+            }
+        }
+        out.entries = out.built.data();
+        out.count = out.built.size();
+        return out;
+    }
+
+    bool ParenIndex::load(const std::string& filename, const FileStamp& stamp)
+    {
+        *this = ParenIndex();
+        MappedFile m;
+        if (!m.open(filename) or m.size() < sizeof(IndexHeader))
+            return false;
+        IndexHeader header;
+        memcpy(&header, m.begin(), sizeof(header));
+        if (memcmp(header.magic, index_magic, sizeof(index_magic)) != 0
+                or !(header.stamp == stamp)
+                or header.count > (m.size() - sizeof(header)) / sizeof(Entry)
+                or m.size() != sizeof(header) + header.count * sizeof(Entry))
+            return false;
+        map = std::move(m);
+        // the mapping is page aligned, and the header a multiple of 8
+        entries = reinterpret_cast<const Entry *>(map.begin() + sizeof(header));
+        count = header.count;
+        return true;
+    }
+
+    static IndexHeader make_header(const FileStamp& stamp, size_t count)
+    {
+        IndexHeader header;
+        memcpy(header.magic, index_magic, sizeof(index_magic));
+        header.stamp = stamp;
+        header.count = count;
+        return header;
+    }
+
+    static bool write_all(int fd, const void *data, size_t n)
+    {
+        const char *p = static_cast<const char *>(data);
+        while (n)
+        {
+            ssize_t w = write(fd, p, n);
+            if (w < 0 and errno == EINTR)
+                continue;
+            if (w <= 0)
+                return false;
+            p += w;
+            n -= w;
+        }
+        return true;
+    }
+
+    void ParenIndex::save(std::ostream& out, const FileStamp& stamp) const
+    {
+        IndexHeader header = make_header(stamp, count);
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char *>(entries), count * sizeof(Entry));
+    }
+
+    bool ParenIndex::save(const std::string& filename, const FileStamp& stamp) const
+    {
+        // written under a fresh name beside it, then renamed over it,
+        // so that no one ever maps half an index, and two processes
+        // saving at once don't write into the same file
+        std::string tmp = filename + ".XXXXXX";
+        int fd = mkstemp(&tmp[0]);
+        if (fd < 0)
+            return false;
+        IndexHeader header = make_header(stamp, count);
+        bool ok = write_all(fd, &header, sizeof(header))
+            and write_all(fd, entries, count * sizeof(Entry));
+        if (close(fd) < 0)
+            ok = false;
+        if (ok and std::rename(tmp.c_str(), filename.c_str()) == 0)
+            return true;
+        std::remove(tmp.c_str());
+        return false;
+    }
+
+    LazySExpr::LazySExpr(const LazyDocument *d, size_t i)
+    : doc(d)
+    , index(i)
+    , value()
+    , parsed(false)
+    {}
+
+    Slice LazySExpr::text() const
+    {
+        const ParenIndex::Entry& entry = doc->index[index];
+        uint64_t size = doc->e - doc->b;
+        if (entry.open >= entry.close or entry.close >= size
+                or doc->b[entry.open] != '(' or doc->b[entry.close] != ')')
+            throw std::runtime_error("the index of " + doc->name + " doesn't match it");
+        return Slice(doc->b + entry.open, doc->b + entry.close + 1);
+    }
+
+    const SExpr& LazySExpr::get() const
+    {
+        if (!parsed)
+        {
+            Slice s = text();
+            // it sees the whole buffer, for positions
+            Parser parser(TrackingStream(doc->name, doc->b, doc->e, s.begin(), s.end(), 0, 0), Atoms::borrow);
+            value = parser.next();
+            parsed = true;
+        }
+        return value;
+    }
+
+    std::vector<LazySExpr> LazySExpr::lists() const
+    {
+        return doc->lists_from(index + 1, doc->index[index].close);
+    }
+
+    std::vector<LazySExpr> LazyDocument::lists_from(size_t i, uint64_t end) const
+    {
+        std::vector<LazySExpr> out;
+        while (i < index.size() and index[i].open < end)
+        {
+            if (index[i].lists >= index.size() - i)
+                throw std::runtime_error("the index of " + name + " is corrupt");
+            out.emplace_back(this, i);
+            // over everything inside it
+            i += 1 + index[i].lists;
+        }
+        return out;
+    }
+
+    LazyDocument::LazyDocument(const std::string& filename, const std::string& index_filename)
+    : name(filename)
+    , map()
+    , buf()
+    , b()
+    , e()
+    , index()
+    {
+        // before reading, so that if it changes meanwhile,
+        // the index is for the old version and won't be used again
+        FileStamp stamp;
+        bool stamped = stamp_file(filename, stamp);
+        if (map.open(filename))
+        {
+            b = map.begin();
+            e = map.end();
+        }
+        else
+        {
+            std::ifstream in(filename, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("can't read " + filename);
+            buf.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            b = buf.data();
+            e = b + buf.size();
+            // not a regular file, so the stamp means nothing
+            stamped = false;
+        }
+        if (stamped and !index_filename.empty() and index.load(index_filename, stamp))
+            return;
+        index = ParenIndex::build(name, b, e);
+        if (stamped and !index_filename.empty())
+            index.save(index_filename, stamp);
+    }
+
+    LazyDocument::LazyDocument(const std::string& filename)
+    : LazyDocument(filename, filename + ".idx")
+    {}
+
+    LazyDocument::LazyDocument(std::string n, const char *begin, const char *end)
+    : name(std::move(n))
+    , map()
+    , buf()
+    , b(begin)
+    , e(end)
+    , index(ParenIndex::build(name, begin, end))
+    {}
+
+    std::vector<LazySExpr> LazyDocument::forms() const
+    {
+        return lists_from(0, std::numeric_limits<uint64_t>::max());
+    }
+} // namespace sexpr
+} // namespace tmwa
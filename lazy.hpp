@@ -0,0 +1,148 @@
+#ifndef TMWA_SEXPR_LAZY_HPP
+#define TMWA_SEXPR_LAZY_HPP
+//    lazy.hpp - Parse only the lists of a file that are looked at.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "mmap.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Which version of a file an index was built from.
+    struct FileStamp
+    {
+        uint64_t size;
+        int64_t mtime_sec, mtime_nsec;
+    };
+    /// Returns false if the file can't be stat()ed.
+    bool stamp_file(const std::string& filename, FileStamp& out);
+
+    /// Where every list of a text begins and ends, in preorder.
+    ///
+    /// Saved, it is a header (magic, version, FileStamp, count) and then
+    /// the entries as they are in memory, so that loading it is just
+    /// mapping it. It is only meant for the machine that wrote it.
+    class ParenIndex
+    {
+    public:
+        struct Entry
+        {
+            // offsets of the '(' and the ')'
+            uint64_t open, close;
+            // how many lists are inside this one, so the next
+            // list after it is this one's index + 1 + lists
+            uint64_t lists;
+        };
+    private:
+        // the entries are in one or the other
+        std::vector<Entry> built;
+        MappedFile map;
+        const Entry *entries;
+        size_t count;
+    public:
+        ParenIndex();
+        ParenIndex(ParenIndex&&) = default;
+        ParenIndex& operator = (ParenIndex&&) = default;
+
+        /// Lex all of [b, e), throwing any errors as a Parser would.
+        static ParenIndex build(const std::string& name, const char *b, const char *e);
+
+        /// Map an index that was saved with the same stamp.
+        /// Returns false, leaving this empty, if the file is missing,
+        /// is for another stamp, or isn't an index.
+        bool load(const std::string& filename, const FileStamp& stamp);
+        /// Write it to a temporary file, and rename that to filename.
+        /// Returns false if that fails.
+        bool save(const std::string& filename, const FileStamp& stamp) const;
+        void save(std::ostream& out, const FileStamp& stamp) const;
+
+        size_t size() const { return count; }
+        const Entry& operator [](size_t i) const { return entries[i]; }
+    };
+
+    class LazyDocument;
+
+    /// One list of a LazyDocument, which is parsed the first time it
+    /// is asked for, and kept. Must not outlive the document.
+    class LazySExpr
+    {
+        const LazyDocument *doc;
+        size_t index;
+        mutable SExpr value;
+        mutable bool parsed;
+    public:
+        LazySExpr(const LazyDocument *d, size_t i);
+
+        /// The text of the list, from '(' to ')'.
+        Slice text() const;
+        /// Parse it, if that hasn't been done yet.
+        const SExpr& get() const;
+        bool is_parsed() const { return parsed; }
+        /// The lists directly inside this one, found without parsing.
+        std::vector<LazySExpr> lists() const;
+    };
+
+    /// A text file, with a ParenIndex of it, so that LazySExprs can
+    /// parse just the lists that are wanted, and get from one list to
+    /// the next without looking at what's inside it.
+    ///
+    /// Atoms outside of every list are not indexed.
+    class LazyDocument
+    {
+        friend class LazySExpr;
+
+        std::string name;
+        MappedFile map;
+        // only used for files that can't be mapped
+        std::string buf;
+        const char *b, *e;
+        ParenIndex index;
+
+        std::vector<LazySExpr> lists_from(size_t first, uint64_t end) const;
+    public:
+        /// Use the index in index_filename if it is up to date;
+        /// otherwise build it, and save it there if possible.
+        /// An empty index_filename means not to save it.
+        ///
+        /// Throws std::runtime_error if the file can't be read.
+        LazyDocument(const std::string& filename, const std::string& index_filename);
+        /// The index is kept in filename + ".idx".
+        explicit LazyDocument(const std::string& filename);
+        /// [begin, end) must outlive the document. The index is built.
+        LazyDocument(std::string name, const char *begin, const char *end);
+        LazyDocument(const LazyDocument&) = delete;
+        LazyDocument& operator = (const LazyDocument&) = delete;
+
+        /// The lists that are not inside another list.
+        std::vector<LazySExpr> forms() const;
+        const ParenIndex& paren_index() const { return index; }
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_LAZY_HPP
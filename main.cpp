@@ -17,14 +17,33 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include "flq.hpp"
 #include "sexpr.hpp"
 #include "parser.hpp"
 #include "ptr.hpp"
 #include "io.hpp"
 #include "script.hpp"
+#include "scan.hpp"
+#include "push_parser.hpp"
+#include "mmap.hpp"
+#include "document.hpp"
+#include "parallel.hpp"
+#include "compact.hpp"
+#include "binary.hpp"
+#include "view.hpp"
+#include "writer.hpp"
+#include "events.hpp"
+#include "lazy.hpp"
 
+#include <chrono>
+#include <iterator>
 #include <string>
 #include <iostream>
+#include <sstream>
+#include <unordered_set>
+
+#include <malloc.h>
+#include <unistd.h>
 
 namespace tmwa
 {
@@ -32,21 +51,481 @@ namespace sexpr
 {
     void echo()
     {
-        Parser parser(TrackingStream("/dev/stdin"));
-        SExpr sex;
-        do
+        // when stdin is a file, echo it without copying any atoms
+        MappedFile map;
+        Parser parser = map.open("/dev/stdin")
+            ? Parser(TrackingStream("/dev/stdin", map.begin(), map.end()), Atoms::borrow)
+            : Parser(TrackingStream("/dev/stdin"));
+        // only a person typing wants to see each form right away
+        bool interactive = isatty(0);
+        Printer out(1);
+        try
+        {
+            for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+            {
+                out.print(sex);
+                out.put('\n');
+                if (interactive)
+                    out.flush();
+            }
+        }
+        catch (...)
+        {
+            // the forms before an error still get printed
+            out.flush();
+            throw;
+        }
+        out.flush();
+    }
+
+    // all of stdin in memory, mapped if possible, else read into buf
+    void slurp_stdin(MappedFile& map, std::string& buf, const char *& b, const char *& e)
+    {
+        if (map.open("/dev/stdin"))
+        {
+            b = map.begin();
+            e = map.end();
+        }
+        else
+        {
+            buf.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+            b = buf.data();
+            e = b + buf.size();
+        }
+    }
+
+    // like echo, but parsing all of stdin at once on every core
+    void parallel()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        Printer out(1);
+        for (const SExpr& sex : parse_parallel("/dev/stdin", b, e, 0, Atoms::borrow))
+        {
+            out.print(sex);
+            out.put('\n');
+        }
+        // ~Printer would ignore a failure
+        out.flush();
+    }
+
+    // text on stdin to binary on stdout
+    void encode()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        List forms;
+        {
+            Parser parser(TrackingStream("/dev/stdin", b, e), Atoms::borrow);
+            for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                forms.push_back(std::move(sex));
+        }
+        std::string out = sexpr::encode(forms);
+        std::cout.write(out.data(), out.size());
+    }
+
+    // binary on stdin to text on stdout, like parallel
+    void decode()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        Printer out(1);
+        for (const SExpr& sex : sexpr::decode(b, e, Atoms::borrow))
+        {
+            out.print(sex);
+            out.put('\n');
+        }
+        // ~Printer would ignore a failure
+        out.flush();
+    }
+
+    // a million made up records, without ever having a tree of them
+    void export_records()
+    {
+        Writer out(1);
+        std::string name;
+        for (int64_t id = 0; id != 1000000; ++id)
+        {
+            out.begin_list();
+            out.atom_token("item");
+            out.atom_int(id);
+            name = "Item \"" + std::to_string(id) + "\"";
+            out.atom_string(name);
+            out.begin_list();
+            out.atom_token("weight");
+            out.atom_int(id % 97 - 48);
+            out.end_list();
+            out.begin_list();
+            out.atom_token("tags");
+            out.begin_list();
+            out.end_list();
+            if (id % 3 == 0)
+                out.atom_token("quest item");
+            out.end_list();
+            out.end_list();
+        }
+        out.finish();
+    }
+
+    // like echo, but feeding stdin to a PushParser a little at a time
+    void push()
+    {
+        PushParser parser("/dev/stdin");
+        // deliberately small, so that most forms arrive in pieces
+        char buf[61];
+        while (std::cin)
         {
-            sex = parser.next();
-            std::cout << sex << std::endl;
+            std::cin.read(buf, sizeof(buf));
+            parser.feed(buf, std::cin.gcount());
+            if (!std::cin)
+                parser.finish();
+            for (SExpr sex = parser.poll(); !sex.is<Void>(); sex = parser.poll())
+                std::cout << sex << std::endl;
         }
-        while (std::cout);
-        std::cout << std::endl;
     }
 
     void help()
     {
-        std::cout << "pass one argument" << std::endl;
-        std::cout << "known arguments: help, echo, script, list, sexpr" << std::endl;
+        std::cout << "pass one argument (and a file, for lazy)" << std::endl;
+        std::cout << "known arguments: help, echo, push, parallel, script, list, sexpr, bench-lex, bench-load, bench-compact, bench-script, bench-binary, bench-view, bench-events, dedup, deep, encode, decode, export, lazy FILE" << std::endl;
+    }
+
+    // lex all of stdin with each scanner, to compare throughput
+    void bench_lex()
+    {
+        // read it all up front, so that only the lexer is timed
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        for (ScanImpl impl : {ScanImpl::scalar, ScanImpl::sse2, ScanImpl::avx2})
+        {
+            if (!scan_impl_available(impl))
+                continue;
+            set_scan_impl(impl);
+            auto start = std::chrono::steady_clock::now();
+            Lexer lexer(TrackingStream("/dev/stdin", b, e));
+            size_t lexemes = 0;
+            while (!lexer.next().is<EndOfStream>())
+                ++lexemes;
+            std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+            std::cout << scan_impl_name(impl) << ": "
+                << lexemes << " lexemes in " << secs.count() << " s, "
+                << (e - b) / secs.count() / 1e6 << " MB/s" << std::endl;
+        }
+    }
+
+    // time loading and freeing all of stdin, on the heap and in an arena
+    void bench_load()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        typedef std::chrono::duration<double> secs;
+        {
+            auto start = std::chrono::steady_clock::now();
+            List forms;
+            {
+                Parser parser(TrackingStream("/dev/stdin", b, e));
+                for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                    forms.push_back(std::move(sex));
+            }
+            auto loaded = std::chrono::steady_clock::now();
+            forms = List();
+            auto freed = std::chrono::steady_clock::now();
+            std::cout << "heap: load " << secs(loaded - start).count()
+                << " s, free " << secs(freed - loaded).count() << " s" << std::endl;
+        }
+        {
+            auto start = std::chrono::steady_clock::now();
+            Unique<Document> doc(TrackingStream("/dev/stdin", b, e));
+            auto loaded = std::chrono::steady_clock::now();
+            size_t bytes = doc->bytes();
+            doc = Unique<Document>(TrackingStream("/dev/stdin", b, b));
+            auto freed = std::chrono::steady_clock::now();
+            std::cout << "arena: load " << secs(loaded - start).count()
+                << " s, free " << secs(freed - loaded).count() << " s, "
+                << bytes << " bytes" << std::endl;
+        }
+    }
+
+    // count the distinct forms of stdin, and check that copied and
+    // borrowed atoms compare equal
+    void dedup()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        List forms;
+        {
+            Parser parser(TrackingStream("/dev/stdin", b, e));
+            for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                forms.push_back(std::move(sex));
+        }
+        Document doc(TrackingStream("/dev/stdin", b, e), Atoms::borrow);
+        const List& borrowed = doc.forms();
+
+        auto start = std::chrono::steady_clock::now();
+        std::unordered_set<SExpr> distinct(forms.begin(), forms.end());
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+        std::cout << forms.size() << " forms, " << distinct.size() << " distinct, hashed in "
+            << secs.count() << " s" << std::endl;
+        std::cout << "borrowed " << (SExpr(forms) == SExpr(borrowed) ? "equal" : "DIFFERENT") << std::endl;
+    }
+
+    // everything that recurses over a tree must fit on the stack
+    // for any depth the parser accepts, even in an unoptimized build
+    void deep()
+    {
+        size_t depth = Lexer::default_max_depth - 1;
+        std::string text = std::string(depth, '(') + "x" + std::string(depth, ')');
+        const char *b = text.data(), *e = text.data() + text.size();
+        Parser parser(TrackingStream("deep", b, e));
+        SExpr tree = parser.next();
+        Document doc(TrackingStream("deep", b, e), Atoms::borrow);
+        {
+            std::ostringstream out;
+            out << tree;
+            std::cout << "print: " << (out.str() == text ? "ok" : "DIFFERENT") << std::endl;
+        }
+        {
+            // a copy of an arena tree is a deep copy onto the heap
+            SExpr copy = doc.forms().front();
+            std::cout << "copy: " << (copy == tree and copy.hash() == tree.hash() ? "ok" : "DIFFERENT") << std::endl;
+        }
+        {
+            List forms = {tree};
+            std::string bin = sexpr::encode(forms);
+            List back = sexpr::decode(bin.data(), bin.data() + bin.size());
+            std::cout << "binary: " << (SExpr(back) == SExpr(forms) ? "ok" : "DIFFERENT") << std::endl;
+        }
+        tree = SExpr();
+        std::cout << "free: ok" << std::endl;
+    }
+
+    // compare loading stdin as text and as binary
+    void bench_binary()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        typedef std::chrono::duration<double> secs;
+        auto start = std::chrono::steady_clock::now();
+        List forms;
+        {
+            Parser parser(TrackingStream("/dev/stdin", b, e));
+            for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                forms.push_back(std::move(sex));
+        }
+        auto parsed = std::chrono::steady_clock::now();
+        std::cout << "text: " << (e - b) << " bytes, parse "
+            << secs(parsed - start).count() << " s" << std::endl;
+        for (Symbols symbols : {Symbols::inline_, Symbols::table})
+        {
+            std::string bin = sexpr::encode(forms, symbols);
+            auto encoded = std::chrono::steady_clock::now();
+            List back = sexpr::decode(bin.data(), bin.data() + bin.size());
+            auto decoded = std::chrono::steady_clock::now();
+            std::cout << (symbols == Symbols::table ? "table" : "inline") << ": "
+                << bin.size() << " bytes, decode "
+                << secs(decoded - encoded).count() << " s, "
+                << (SExpr(back) == SExpr(forms) ? "same" : "DIFFERENT") << std::endl;
+        }
+    }
+
+    class CountEvents : public EventHandler
+    {
+    public:
+        size_t events = 0;
+
+        Flow begin_list(Position) override { ++events; return Flow::proceed; }
+        Flow end_list(Position) override { ++events; return Flow::proceed; }
+        Flow atom_int(Position, int64_t) override { ++events; return Flow::proceed; }
+        Flow atom_string(Position, Slice) override { ++events; return Flow::proceed; }
+        Flow atom_token(Position, Slice) override { ++events; return Flow::proceed; }
+    };
+
+    // only looks at the first element of each form
+    class FirstElements : public EventHandler
+    {
+        bool in_form = false;
+    public:
+        size_t forms = 0, tokens = 0;
+
+        Flow begin_list(Position) override
+        {
+            if (in_form)
+                return Flow::skip;
+            in_form = true;
+            ++forms;
+            return Flow::proceed;
+        }
+        Flow end_list(Position) override
+        {
+            in_form = false;
+            return Flow::proceed;
+        }
+        Flow atom_token(Position, Slice) override
+        {
+            tokens += in_form;
+            in_form = false;
+            return Flow::skip;
+        }
+        Flow atom_int(Position, int64_t) override
+        {
+            in_form = false;
+            return Flow::skip;
+        }
+        Flow atom_string(Position, Slice) override
+        {
+            in_form = false;
+            return Flow::skip;
+        }
+    };
+
+    // compare building trees, seeing every event, and skipping most
+    void bench_events()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        typedef std::chrono::duration<double> secs;
+        auto start = std::chrono::steady_clock::now();
+        size_t forms = 0;
+        {
+            Parser parser(TrackingStream("/dev/stdin", b, e), Atoms::borrow);
+            for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                ++forms;
+        }
+        auto parsed = std::chrono::steady_clock::now();
+        CountEvents count;
+        EventParser(TrackingStream("/dev/stdin", b, e)).run(count);
+        auto counted = std::chrono::steady_clock::now();
+        FirstElements first;
+        EventParser(TrackingStream("/dev/stdin", b, e)).run(first);
+        auto skimmed = std::chrono::steady_clock::now();
+        std::cout << "trees: " << forms << " forms " << secs(parsed - start).count() << " s, "
+            << "events: " << count.events << " " << secs(counted - parsed).count() << " s, "
+            << "first elements: " << first.tokens << " tokens in " << first.forms << " lists "
+            << secs(skimmed - counted).count() << " s" << std::endl;
+    }
+
+    // print the last form of a file, parsing as little as possible
+    void lazy(const std::string& filename)
+    {
+        typedef std::chrono::duration<double> secs;
+        auto start = std::chrono::steady_clock::now();
+        LazyDocument doc(filename);
+        auto opened = std::chrono::steady_clock::now();
+        std::vector<LazySExpr> forms = doc.forms();
+        if (forms.empty())
+            return;
+        const SExpr& last = forms.back().get();
+        auto parsed = std::chrono::steady_clock::now();
+        std::cout << last << std::endl;
+        std::cerr << doc.paren_index().size() << " lists, " << forms.size() << " forms; open "
+            << secs(opened - start).count() << " s, find and parse the last "
+            << secs(parsed - opened).count() << " s" << std::endl;
+    }
+
+    static size_t count_nodes(const SExprView& view)
+    {
+        size_t out = 1;
+        if (view.is_list())
+            for (const SExprView& e : view.elements())
+                out += count_nodes(e);
+        return out;
+    }
+
+    // binary on stdin: compare opening it in place and decoding it
+    void bench_view()
+    {
+        typedef std::chrono::duration<double> secs;
+        auto start = std::chrono::steady_clock::now();
+        BinaryDocument doc("/dev/stdin");
+        auto opened = std::chrono::steady_clock::now();
+        ListView forms = doc.forms();
+        size_t nodes = 0;
+        for (const SExprView& form : forms)
+            nodes += count_nodes(form);
+        auto walked = std::chrono::steady_clock::now();
+        // O(1) per form, however big
+        size_t skipped = 0;
+        for (auto it = forms.begin(); it != forms.end(); ++it)
+            ++skipped;
+        auto skimmed = std::chrono::steady_clock::now();
+        List decoded = decode(doc.begin(), doc.end(), Atoms::borrow);
+        auto done = std::chrono::steady_clock::now();
+        std::cout << "open " << secs(opened - start).count() << " s ("
+            << doc.symbol_count() << " symbols), walk " << nodes << " nodes "
+            << secs(walked - opened).count() << " s, skip " << skipped << " forms "
+            << secs(skimmed - walked).count() << " s, decode "
+            << secs(done - skimmed).count() << " s" << std::endl;
+        bool same = forms.size() == decoded.size();
+        for (size_t i = 0; same and i != decoded.size(); ++i)
+            same = forms[i].materialize() == decoded[i];
+        std::cout << (same ? "same" : "DIFFERENT") << std::endl;
+    }
+
+    static size_t count_nodes(const CompactSExpr& sex)
+    {
+        size_t nodes = 1;
+        if (auto l = sex.get_if<ListRef>())
+            for (const CompactSExpr& item : *l)
+                nodes += count_nodes(item);
+        return nodes;
+    }
+
+    static size_t heap_in_use()
+    {
+        // mallinfo2 is new in glibc 2.33; mallinfo's ints wrap past 2 GiB
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        return mallinfo2().uordblks;
+#else
+        return static_cast<unsigned int>(mallinfo().uordblks);
+#endif
+    }
+
+    // heap memory per node of all of stdin, as SExprs and compacted
+    void bench_compact()
+    {
+        MappedFile map;
+        std::string buf;
+        const char *b, *e;
+        slurp_stdin(map, buf, b, e);
+        // intern every token first, so neither is charged for the symbols
+        {
+            Parser parser(TrackingStream("/dev/stdin", b, e));
+            while (!parser.next().is<Void>())
+            {}
+        }
+        size_t before = heap_in_use();
+        List forms;
+        {
+            Parser parser(TrackingStream("/dev/stdin", b, e));
+            for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                forms.push_back(std::move(sex));
+        }
+        size_t loose = heap_in_use() - before;
+        CompactSExpr compact(forms);
+        size_t packed = heap_in_use() - before - loose;
+        // not counting the list of forms itself
+        size_t nodes = count_nodes(compact) - 1;
+        std::cout << nodes << " nodes" << std::endl;
+        std::cout << "SExpr: " << sizeof(SExpr) << " bytes inline, "
+            << double(loose) / nodes << " bytes/node" << std::endl;
+        std::cout << "CompactSExpr: " << sizeof(CompactSExpr) << " bytes inline, "
+            << double(packed) / nodes << " bytes/node" << std::endl;
     }
 
     void script_inner_loop(bool interactive, Environment& env, Parser& parser, std::function<void(void)>& resume)
@@ -85,6 +564,21 @@ namespace sexpr
         std::cout << '\n';
     }
 
+    // run a script from stdin, then show how its Values were allocated
+    void bench_script()
+    {
+        auto start = std::chrono::steady_clock::now();
+        script(false);
+        std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
+        ValueCounts counts = value_counts();
+        std::cout << secs.count() << " s, "
+            << counts.allocated << " values allocated ("
+            << counts.pooled << " pooled, "
+            << counts.live << " live, "
+            << counts.slab_bytes << " slab bytes), "
+            << counts.cached_ints << " cached ints" << std::endl;
+    }
+
     void ptr()
     {
         Unique<std::string> u(3, 'x');
@@ -125,7 +619,7 @@ namespace sexpr
         }
     }
 
-    void main(std::string arg)
+    void main(std::string arg, std::string file)
     {
         if (arg == "list")
         {
@@ -146,6 +640,14 @@ namespace sexpr
         {
             echo();
         }
+        else if (arg == "push")
+        {
+            push();
+        }
+        else if (arg == "parallel")
+        {
+            parallel();
+        }
         else if (arg == "script")
         {
             script(false);
@@ -162,6 +664,58 @@ namespace sexpr
         {
             match();
         }
+        else if (arg == "encode")
+        {
+            encode();
+        }
+        else if (arg == "decode")
+        {
+            decode();
+        }
+        else if (arg == "bench-binary")
+        {
+            bench_binary();
+        }
+        else if (arg == "bench-view")
+        {
+            bench_view();
+        }
+        else if (arg == "export")
+        {
+            export_records();
+        }
+        else if (arg == "bench-events")
+        {
+            bench_events();
+        }
+        else if (arg == "lazy" and !file.empty())
+        {
+            lazy(file);
+        }
+        else if (arg == "dedup")
+        {
+            dedup();
+        }
+        else if (arg == "deep")
+        {
+            deep();
+        }
+        else if (arg == "bench-lex")
+        {
+            bench_lex();
+        }
+        else if (arg == "bench-load")
+        {
+            bench_load();
+        }
+        else if (arg == "bench-compact")
+        {
+            bench_compact();
+        }
+        else if (arg == "bench-script")
+        {
+            bench_script();
+        }
         else
         {
             help();
@@ -174,7 +728,9 @@ namespace sexpr
 int main(int argc, char **argv)
 {
     if (argc == 2)
-        tmwa::sexpr::main(argv[1]);
+        tmwa::sexpr::main(argv[1], "");
+    else if (argc == 3)
+        tmwa::sexpr::main(argv[1], argv[2]);
     else
         tmwa::sexpr::help();
 }
@@ -0,0 +1,99 @@
+#include "mmap.hpp"
+//    mmap.cpp - Read-only memory mapping of a regular file.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    MappedFile::MappedFile()
+    : addr(nullptr)
+    , len(0)
+    {}
+
+    MappedFile::MappedFile(MappedFile&& r)
+    : addr(r.addr)
+    , len(r.len)
+    {
+        r.addr = nullptr;
+        r.len = 0;
+    }
+
+    MappedFile& MappedFile::operator = (MappedFile&& r)
+    {
+        if (this != &r)
+        {
+            close();
+            addr = r.addr;
+            len = r.len;
+            r.addr = nullptr;
+            r.len = 0;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        close();
+    }
+
+    bool MappedFile::open(const std::string& filename)
+    {
+        close();
+        int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == -1 or !S_ISREG(st.st_mode))
+        {
+            ::close(fd);
+            return false;
+        }
+        if (st.st_size == 0)
+        {
+            // mmap refuses zero-length mappings
+            ::close(fd);
+            return true;
+        }
+        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        // the mapping keeps its own reference to the file
+        ::close(fd);
+        if (p == MAP_FAILED)
+            return false;
+        // the lexer reads front to back exactly once
+        madvise(p, st.st_size, MADV_SEQUENTIAL);
+        addr = static_cast<const char *>(p);
+        len = st.st_size;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (addr)
+            munmap(const_cast<char *>(addr), len);
+        addr = nullptr;
+        len = 0;
+    }
+} // namespace sexpr
+} // namespace tmwa
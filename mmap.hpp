@@ -0,0 +1,56 @@
+#ifndef TMWA_SEXPR_MMAP_HPP
+#define TMWA_SEXPR_MMAP_HPP
+//    mmap.hpp - Read-only memory mapping of a regular file.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <string>
+#include <cstddef>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Owns a read-only private mapping of a whole file.
+    class MappedFile
+    {
+        const char *addr;
+        size_t len;
+    public:
+        MappedFile();
+        MappedFile(MappedFile&&);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator = (MappedFile&&);
+        MappedFile& operator = (const MappedFile&) = delete;
+        ~MappedFile();
+
+        /// Map a regular file.
+        /// Returns false, leaving this empty, for anything that cannot
+        /// be mapped: pipes, ttys, sockets, nonexistent files ...
+        /// An empty regular file succeeds with begin() == end().
+        bool open(const std::string& filename);
+        void close();
+
+        const char *begin() const { return addr; }
+        const char *end() const { return addr + len; }
+        size_t size() const { return len; }
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_MMAP_HPP
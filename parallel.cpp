@@ -0,0 +1,123 @@
+#include "parallel.hpp"
+//    parallel.cpp - Parse a large buffer on several threads.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
+#include <cstring>
+
+#include "forms.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    // smaller pieces aren't worth starting a Parser for
+    static const size_t min_piece = 64 * 1024;
+
+    /// Where the pieces start; the last element is e.
+    static std::vector<const char *> split(const char *b, const char *e, size_t target)
+    {
+        std::vector<const char *> cuts{b};
+        const char *p = b;
+#if HANDLE_SHEBANG_SPECIALLY
+        // the first piece skips it, but it must not confuse the scanner
+        if (e - b >= 2 and b[0] == '#' and b[1] == '!')
+        {
+            const char *nl = static_cast<const char *>(memchr(b, '\n', e - b));
+            p = nl ? nl + 1 : e;
+        }
+#endif
+        FormScanner scanner;
+        while (const char *end = scanner.scan(p, e))
+        {
+            p = end;
+            if (size_t(p - cuts.back()) >= target)
+                cuts.push_back(p);
+        }
+        if (cuts.back() != e)
+            cuts.push_back(e);
+        return cuts;
+    }
+
+    std::vector<SExpr> parse_parallel(const std::string& name,
+            const char *b, const char *e,
+            unsigned threads, Atoms atoms)
+    {
+        if (!threads)
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        // several pieces per thread, so that one slow piece
+        // doesn't leave the other threads idle at the end
+        size_t target = std::max<size_t>((e - b) / (threads * 4), min_piece);
+        std::vector<const char *> cuts = split(b, e, target);
+        size_t pieces = cuts.size() - 1;
+
+        std::vector<List> forms(pieces);
+        std::vector<std::exception_ptr> errors(pieces);
+        std::atomic<size_t> next(0);
+        // pieces after one with an error don't need parsing;
+        // pieces are taken in order, so all the ones before it are
+        std::atomic<size_t> first_error(pieces);
+        auto work = [&]()
+        {
+            for (size_t i; (i = next++) < pieces and i < first_error; )
+            {
+                try
+                {
+                    // every piece sees the whole buffer, for positions
+                    Parser parser(TrackingStream(name, b, e, cuts[i], cuts[i + 1], 0, 0), atoms);
+                    for (SExpr sex = parser.next(); !sex.is<Void>(); sex = parser.next())
+                        forms[i].push_back(std::move(sex));
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                    size_t prev = first_error;
+                    while (i < prev and !first_error.compare_exchange_weak(prev, i))
+                    {}
+                }
+            }
+        };
+
+        std::vector<std::thread> helpers;
+        for (size_t t = 1; t < std::min<size_t>(threads, pieces); ++t)
+            helpers.emplace_back(work);
+        work();
+        for (std::thread& t : helpers)
+            t.join();
+
+        if (first_error < pieces)
+            std::rethrow_exception(errors[first_error]);
+
+        size_t total = 0;
+        for (const List& l : forms)
+            total += l.size();
+        // reserved, so that the forms are moved only once
+        std::vector<SExpr> out;
+        out.reserve(total);
+        for (List& l : forms)
+            for (SExpr& sex : l)
+                out.push_back(std::move(sex));
+        return out;
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,47 @@
+#ifndef TMWA_SEXPR_PARALLEL_HPP
+#define TMWA_SEXPR_PARALLEL_HPP
+//    parallel.hpp - Parse a large buffer on several threads.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <string>
+#include <vector>
+
+#include "parser.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Parse all of [b, e), which must stay alive while this runs
+    /// (and, with Atoms::borrow, as long as the result).
+    ///
+    /// A FormScanner splits the buffer at top-level form boundaries,
+    /// then the pieces are parsed by up to `threads` threads
+    /// (0 means one per core). The forms are returned in order, and
+    /// positions and errors are the same as a single Parser would give:
+    /// if several pieces have errors, the first one is thrown.
+    std::vector<SExpr> parse_parallel(const std::string& name,
+            const char *b, const char *e,
+            unsigned threads = 0, Atoms atoms = Atoms::copy);
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_PARALLEL_HPP
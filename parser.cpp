@@ -18,6 +18,14 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <type_traits>
+
+#include <cctype>
+#include <cstdint>
+
+#include "forms.hpp"
+#include "scan.hpp"
+
 namespace tmwa
 {
 namespace sexpr
@@ -104,27 +112,183 @@ namespace sexpr
         }
     }
 
+    /// Collects the bytes of a String or Token.
+    /// When borrowing, nothing is copied until a backslash is seen,
+    /// or the bytes stop being one run of lasting memory.
+    class AtomText
+    {
+        const char *run, *run_end;
+        bool copied;
+        std::string copy;
+        Arena *arena;
+
+        void materialize()
+        {
+            if (!copied)
+                copy.assign(run, run_end);
+            copied = true;
+        }
+    public:
+        AtomText(Atoms atoms, Arena *a)
+        : run()
+        , run_end()
+        , copied(atoms == Atoms::copy)
+        , copy()
+        , arena(a)
+        {}
+
+        void append(TrackingStream& source, const char *b, const char *e)
+        {
+            if (!copied and (!run or run_end == b) and source.lasting(b, e))
+            {
+                if (!run)
+                    run = b;
+                run_end = e;
+                return;
+            }
+            materialize();
+            copy.append(b, e);
+        }
+
+        void push_back(char c)
+        {
+            materialize();
+            copy += c;
+        }
+
+        const char *begin() const { return copied ? copy.data() : run; }
+        const char *end() const { return copied ? copy.data() + copy.size() : run_end; }
+
+        template<class Owned, class Borrowed>
+        Lexeme finish()
+        {
+            // Tokens are interned, so they never need the arena
+            if (copied and arena and !std::is_same<Owned, Token>::value)
+            {
+                const char *b = arena->copy(copy.data(), copy.data() + copy.size());
+                return Borrowed(Slice(b, b + copy.size()));
+            }
+            if (copied)
+                return Owned(std::move(copy));
+            return Borrowed(Slice(run, run_end));
+        }
+    };
+
+    enum class IntParse
+    {
+        not_int,
+        ok,
+        overflow,
+    };
+
+    static bool is_c_space(char c)
+    {
+        return c == ' ' or ('\t' <= c and c <= '\r');
+    }
+
+    /// Accepts exactly what strtoll(.., 0) accepts when it uses the whole
+    /// string: leading whitespace, a sign, and decimal, 0x hex or 0 octal
+    /// digits. Like strtoll, overflow is reported even if there are
+    /// other characters after the digits.
+    static IntParse parse_int(const char *b, const char *e, int64_t& out)
+    {
+        while (b != e and is_c_space(*b))
+            ++b;
+        bool neg = false;
+        if (b != e and (*b == '-' or *b == '+'))
+            neg = *b++ == '-';
+        if (b == e)
+            return IntParse::not_int;
+
+        unsigned base = 10;
+        if (*b == '0')
+        {
+            base = 8;
+            if (e - b >= 3 and (b[1] | 0x20) == 'x' and isxdigit(static_cast<unsigned char>(b[2])))
+            {
+                base = 16;
+                b += 2;
+            }
+        }
+
+        uint64_t limit = neg ? uint64_t(INT64_MAX) + 1 : uint64_t(INT64_MAX);
+        uint64_t value = 0;
+        bool overflow = false;
+        const char *digits = b;
+        for (; b != e; ++b)
+        {
+            unsigned char c = *b;
+            unsigned d = c - '0';
+            if (base == 16 and d > 9)
+            {
+                // not (c | 0x20) - 'a', which would take '@' and '`' for 9
+                unsigned char lower = c | 0x20;
+                d = 'a' <= lower and lower <= 'f' ? lower - 'a' + 10u : base;
+            }
+            if (d >= base)
+                break;
+            overflow |= __builtin_mul_overflow(value, base, &value);
+            overflow |= __builtin_add_overflow(value, d, &value);
+        }
+        if (overflow or value > limit)
+            return IntParse::overflow;
+        if (b == digits or b != e)
+            return IntParse::not_int;
+        out = neg ? int64_t(0 - value) : int64_t(value);
+        return IntParse::ok;
+    }
+
+    /// A token that only a number could start with is tried as an integer;
+    /// anything else, like every identifier, never gets that far.
+    static Lexeme finish_token(AtomText& tok, const Position& pos)
+    {
+        const char *b = tok.begin(), *e = tok.end();
+        char c = *b;
+        if (('0' <= c and c <= '9') or c == '-' or c == '+' or is_c_space(c))
+        {
+            int64_t value;
+            switch (parse_int(b, e, value))
+            {
+            case IntParse::not_int:
+                break;
+            case IntParse::ok:
+                return Int(value);
+            case IntParse::overflow:
+                throw Unexpected(pos, "out of range int");
+            }
+        }
+        return tok.finish<Token, TokenRef>();
+    }
+
     Lexeme Lexer::next()
     {
         source.off_eof();
-        char ch;
-        Position pos;
-        do
+        while (true)
         {
             if (!source)
             {
                 if (!depth.empty())
                     throw Unexpected(depth.back(), "unmatched '('");
-                else
-                    return EndOfStream();
+                last = source.position();
+                return EndOfStream();
             }
-            pos = source.position();
-            ch = *source++;
+            const char *p = scan.skip_blanks(source.here(), source.line_end());
+            bool eol = p == source.line_end();
+            source.skip_to(p);
+            if (!eol)
+                break;
         }
-        while (ch == ' ' || ch == '\n');
         // whitespace has been skipped
+        Position pos = last = source.position();
+        if (depth.empty())
+            // no error can point before this lexeme any more
+            source.forget_before(pos);
+        const char *first = source.here();
+        char ch = *source++;
         if (ch == '(')
         {
+            if (depth.size() >= max_depth)
+                throw Unexpected(pos, "'(' nested too deeply");
             depth.push_back(pos);
             return BeginList();
         }
@@ -137,141 +301,176 @@ namespace sexpr
         }
         if (ch == '"')
         {
-            std::string s;
+            AtomText s(atoms, arena);
             source.on_eof("EOF in string literal");
             while (true)
             {
-                ch = *source++;
-                if (ch == '"')
-                    return String(s);
-                if (ch != '\\')
+                // strings may span lines, so the run may end at the line end
+                const char *b = source.here();
+                const char *p = scan.find_string_end(b, source.line_end());
+                s.append(source, b, p);
+                if (p == source.line_end())
                 {
-                    s += ch;
+                    source.skip_to(p);
                     continue;
                 }
+                source.skip_to(p);
+                ch = *source++;
+                if (ch == '"')
+                    return s.finish<String, StringRef>();
                 source.on_eof("EOF in backslash sequence in string literal");
-                s += read_after_backslash();
+                s.push_back(read_after_backslash());
                 source.on_eof("EOF in string literal");
             }
         }
 
         // if we get here, it's either a token or an integer
-        // (they are distinguished by the parser)
+        // (they are distinguished once the whole token has been read)
         // (yes, this means that \x30 is a valid integer)
-        std::string tok;
+        AtomText tok(atoms, arena);
         if (ch != '\\')
-            tok += ch;
+            tok.append(source, first, first + 1);
         else
         {
             source.on_eof("EOF in backslash sequence in token");
-            tok += read_after_backslash();
+            tok.push_back(read_after_backslash());
             source.off_eof();
         }
 
         // EOF is fine in a token
         while (source)
         {
-            char ch = *source;
-            if (ch == ' ' || ch == '\n')
-            {
-                return Token(tok);
-            }
+            // every line ends in a '\n', so the run never reaches the line end
+            const char *b = source.here();
+            const char *p = scan.find_token_end(b, source.line_end());
+            tok.append(source, b, p);
+            source.skip_to(p);
 
-            if (ch == '(' || ch == '"' || ch == ')')
+            char ch = *source;
+            if (ch != '\\')
             {
                 // used to give a warning about being hard to parse
+                // if followed by '(', '"', or ')'
                 // removed since I'm the only one parsing and I solved it
-                return Token(tok);
+                return finish_token(tok, pos);
             }
 
             ++source;
+            source.on_eof("EOF in backslash sequence in token");
+            tok.push_back(read_after_backslash());
+            source.off_eof();
+        }
+        return finish_token(tok, pos); // hit EOF
+    }
 
-            if (ch != '\\')
-                tok += ch;
-            else
+    void Lexer::skip_list()
+    {
+        // one '(' has been read, so the first form that the scanner
+        // finds the end of is the rest of this list
+        FormScanner scanner(1);
+        while (source)
+        {
+            const char *p = scanner.scan(source.here(), source.line_end());
+            if (p)
             {
-                source.on_eof("EOF in backslash sequence in token");
-                tok += read_after_backslash();
-                source.off_eof();
+                source.skip_to(p);
+                depth.pop_back();
+                return;
             }
+            source.skip_to(source.line_end());
         }
-        return Token(tok); // hit EOF
+        throw Unexpected(depth.back(), "unmatched '('");
     }
 
-    class MaybeEndList
+    /// Turns one lexeme into a step of building the tree.
+    /// Returns true when *item has been set to a finished item,
+    /// which is either an atom or a list that was just closed.
+    class BuildTree
     {
-        List *out;
+        vq<SExpr> *items;
+        std::vector<size_t> *open;
+        Arena *arena;
+        SExpr *item;
     public:
-        MaybeEndList(List *l) : out(l) {}
-        bool operator () (Void) { return false; }
-        template<class T>
-        bool operator () (T t) { out->push_back(t); return true; }
-    };
-
-    class ApplyMaybeList
-    {
-        Parser *parser;
-    public:
-        ApplyMaybeList(Parser *p)
-        : parser(p)
+        BuildTree(vq<SExpr> *is, std::vector<size_t> *o, Arena *a, SExpr *i)
+        : items(is)
+        , open(o)
+        , arena(a)
+        , item(i)
         {}
-        SExpr operator () (EndOfStream)
+        bool operator () (EndOfStream)
         {
-            return Void();
+            // the Lexer has already complained about any unclosed lists
+            return true;
         }
-        SExpr operator () (BeginList)
+        bool operator () (BeginList)
         {
-            // size_t line = bl.line;
-            // size_t column = bl.column;
-            List out;
-            bool keep_going = true;
-            while (keep_going)
-            {
-                SExpr nx = parser->next();
-                apply(keep_going, MaybeEndList(&out), nx);
-            }
-            return out;
+            open->push_back(items->size());
+            return false;
         }
-        SExpr operator () (EndList)
+        bool operator () (EndList)
         {
-            return Void();
+            // the Lexer balances the parentheses for us
+            size_t first = open->back();
+            open->pop_back();
+            // now that its size is known, the list is allocated just once
+            ArenaAllocator<SExpr> alloc(arena);
+            List l(alloc);
+            l.reserve(items->size() - first);
+            for (auto it = items->begin() + first, end = items->end(); it != end; ++it)
+                l.emplace_back(std::move(*it));
+            while (items->size() > first)
+                items->pop_back();
+            *item = std::move(l);
+            return true;
         }
-        SExpr operator () (String s)
+        bool operator () (String s)
         {
-            return s;
+            *item = std::move(s);
+            return true;
         }
-        SExpr operator () (Token t)
+        bool operator () (StringRef s)
         {
-            const char *cstr = t.value.c_str();
-            char *end;
-            errno = 0;
-            long long l = strtoll(cstr, &end, 0);
-            switch(errno)
-            {
-            default:
-                abort();
-            case 0:
-            case EINVAL:
-                break;
-            case ERANGE:
-                throw Unexpected(Position{"<unknown>", 0, 0, ""}, "out of range int");
-            }
-            if (size_t(end - cstr) != t.value.size())
-                return t;
-            return Int(l);
-        };
+            *item = s;
+            return true;
+        }
+        bool operator () (Int i)
+        {
+            *item = i;
+            return true;
+        }
+        bool operator () (Token t)
+        {
+            *item = std::move(t);
+            return true;
+        }
+        bool operator () (TokenRef t)
+        {
+            *item = t;
+            return true;
+        }
     };
 
     SExpr Parser::next()
     {
         // publically, returns an SExpr containing Void on eof.
-        // Internally, also returns a Void to handle end-of-list.
-        // This is safe because the Lexer balances the parentheses for us.
-        Lexeme lx = lexer.next();
-
-        SExpr out;
-        apply(out, ApplyMaybeList(this), lx);
-        return out;
+        // Lists are built on an explicit stack rather than by recursion,
+        // so the depth is only limited by the Lexer, and each finished
+        // item is moved onto the stack until its list is closed.
+        // (anything left from a form that threw is abandoned)
+        items.clear();
+        open.clear();
+        while (true)
+        {
+            SExpr item;
+            bool done;
+            apply(done, BuildTree(&items, &open, arena, &item), lexer.next());
+            if (!done)
+                continue;
+            if (open.empty())
+                return item;
+            items.emplace_back(std::move(item));
+        }
     }
 } // namespace sexpr
 } // namespace tmwa
@@ -25,6 +25,7 @@
 #include "tracking_stream.hpp"
 #include "variant.hpp"
 #include "sexpr.hpp"
+#include "vq.hpp"
 
 namespace tmwa
 {
@@ -36,43 +37,103 @@ namespace sexpr
     class EndOfStream {};
 
     /// subclass instead of typedef just to get cleaner error messages
-    class Lexeme : public Variant<EndOfStream, BeginList, EndList, String, Token>
+    class Lexeme : public Variant<EndOfStream, BeginList, EndList, Int, String, Token, StringRef, TokenRef>
     {
     public:
         template<class... A>
         Lexeme(A&&... a)
-        : Variant<EndOfStream, BeginList, EndList, String, Token>(std::forward<A>(a)...)
+        : Variant<EndOfStream, BeginList, EndList, Int, String, Token, StringRef, TokenRef>(std::forward<A>(a)...)
         {}
     };
 
+    /// How the lexer makes String and Token atoms.
+    enum class Atoms
+    {
+        /// Every atom owns a copy of its bytes.
+        copy,
+        /// Atoms without a backslash are StringRef and TokenRef,
+        /// pointing into the buffer the TrackingStream was made from.
+        /// That buffer must outlive them. Atoms from anywhere else
+        /// (streams, or a last line without a '\n') are still copied.
+        borrow,
+    };
+
     /// Parse an character input stream into almost-iterator over lexemes.
-    /// Also balances parentheses.
+    /// Also balances parentheses, and decides which tokens are integers.
     class Lexer // : public std::iterator<std::input_iterator_tag, Lexeme>
     {
         TrackingStream source;
         // could be just an int, but this gives debug info
         std::vector<Position> depth;
+        size_t max_depth;
+        Atoms atoms;
+        Arena *arena;
+        Position last;
 
         char read_after_backslash();
     public:
         Lexer(Lexer&&) = default;
-        Lexer(TrackingStream in) : source(std::move(in)) {}
+        Lexer(TrackingStream in, Atoms a = Atoms::copy)
+        : source(std::move(in))
+        , depth()
+        , max_depth(default_max_depth)
+        , atoms(a)
+        , arena()
+        , last()
+        {}
         Lexeme next();
+        /// Where the lexeme last returned by next() began.
+        Position position() const { return last; }
+        /// Skip to just after the ')' that closes the innermost open list,
+        /// as if its EndList had been returned.
+        ///
+        /// The skipped text is only scanned for where it ends,
+        /// not lexed, so errors in it (other than a missing ')',
+        /// or characters that are never allowed) go unreported.
+        void skip_list();
+
+        /// Deep enough for anything written by hand, but shallow enough
+        /// that the recursive printing and destruction of the result
+        /// still fit on the stack.
+        static constexpr size_t default_max_depth = 10000;
+        /// A '(' nested more deeply than this is an error.
+        void limit_depth(size_t n) { max_depth = n; }
+        /// Strings that would be copied are copied into the arena instead,
+        /// and made into StringRef. (Tokens are interned anyway.)
+        void use_arena(Arena *a) { arena = a; }
     };
 
     /// Parse a lexeme stream into an an almost-iterator of SExpr trees
     class Parser
     {
         Lexer lexer;
+        // the items of the lists that have been opened but not closed,
+        // and where each list's items start, innermost last;
+        // kept between calls only to reuse the allocation
+        vq<SExpr> items;
+        std::vector<size_t> open;
+        Arena *arena;
     public:
         Parser(Parser&&) = default;
         Parser(Lexer l)
         : lexer(std::move(l))
+        , items()
+        , open()
+        , arena()
         {}
-        Parser(TrackingStream ts)
-        : lexer(std::move(ts))
+        Parser(TrackingStream ts, Atoms a = Atoms::copy)
+        : lexer(std::move(ts), a)
+        , items()
+        , open()
+        , arena()
         {}
         SExpr next();
+
+        void limit_depth(size_t n) { lexer.limit_depth(n); }
+        /// Build lists and atoms in the arena, which must outlive them.
+        /// Nothing else in the result owns any memory, so the trees need
+        /// never be destroyed.
+        void use_arena(Arena *a) { arena = a; lexer.use_arena(a); }
     };
 } // namespace sexpr
 } // namespace tmwa
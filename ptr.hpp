@@ -19,8 +19,11 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <atomic>
 #include <memory>
 
+#include <cstddef>
+
 namespace tmwa
 {
 namespace sexpr
@@ -30,6 +33,76 @@ namespace sexpr
     template<class T>
     class Shared;
 
+    /// The counts for RefCounted.
+    class AtomicCount
+    {
+        std::atomic<size_t> n;
+    public:
+        AtomicCount() : n(0) {}
+        void inc() { n.fetch_add(1, std::memory_order_relaxed); }
+        /// Whether that was the last reference.
+        bool dec() { return n.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+    };
+    /// Only for objects that never leave the thread that made them.
+    class PlainCount
+    {
+        size_t n;
+    public:
+        PlainCount() : n(0) {}
+        void inc() { ++n; }
+        bool dec() { return !--n; }
+    };
+
+    class RefCountedBase
+    {};
+
+    /// Derive from this (publicly) for Shared<T> to count references
+    /// in the object, rather than in std::shared_ptr's control block.
+    template<class Count = AtomicCount>
+    class RefCounted : public RefCountedBase
+    {
+        template<class U>
+        friend class Intrusive;
+
+        mutable Count refs;
+    protected:
+        RefCounted() : refs() {}
+        // a copy is a different object, with its own references
+        RefCounted(const RefCounted&) : refs() {}
+        RefCounted& operator = (const RefCounted&) { return *this; }
+        ~RefCounted() = default;
+    };
+
+    /// What Shared<T> holds if T is RefCounted:
+    /// just enough of std::shared_ptr for it.
+    template<class T>
+    class Intrusive
+    {
+        template<class U>
+        friend class Intrusive;
+
+        T *ptr;
+    public:
+        explicit Intrusive(T *p);
+        template<class U>
+        Intrusive(std::unique_ptr<U>&& u);
+        Intrusive(const Intrusive& r);
+        Intrusive(Intrusive&& r) noexcept;
+        template<class U>
+        Intrusive(Intrusive<U>&& r) noexcept;
+        Intrusive& operator = (Intrusive r) noexcept;
+        ~Intrusive();
+
+        T& operator *() const { return *ptr; }
+    };
+
+    template<class T>
+    struct _shared_impl
+    {
+        typedef typename std::conditional<std::is_base_of<RefCountedBase, T>::value,
+                Intrusive<T>, std::shared_ptr<T>>::type type;
+    };
+
     template<class T>
     class Unique
     {
@@ -48,7 +121,9 @@ namespace sexpr
 
         Unique(const Unique&&) = delete;
 
-        template<class U>
+        // constrained, else it would hijack Unique<X>(Unique<Y>(...))
+        // from the forwarding constructor for unrelated X and Y
+        template<class U, class=typename std::enable_if<std::is_base_of<T, U>::value>::type>
         Unique(Unique<U>);
 
         Unique& operator = (Unique&&) = default;
@@ -69,7 +144,7 @@ namespace sexpr
         template<class U>
         friend class Shared;
 
-        std::shared_ptr<T> impl;
+        typename _shared_impl<T>::type impl;
     public:
         template<class... A>
 
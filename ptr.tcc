@@ -43,7 +43,7 @@ namespace sexpr
 #endif
 
     template<class T>
-    template<class U>
+    template<class U, class>
     Unique<T>::Unique(Unique<U> u)
     : impl(std::move(u.impl))
     {
@@ -76,10 +76,70 @@ namespace sexpr
         return &*impl;
     }
 
+    template<class T>
+    Intrusive<T>::Intrusive(T *p)
+    : ptr(p)
+    {
+        if (ptr)
+            ptr->refs.inc();
+    }
+
+    template<class T>
+    template<class U>
+    Intrusive<T>::Intrusive(std::unique_ptr<U>&& u)
+    : Intrusive(u.release())
+    {}
+
+    template<class T>
+    Intrusive<T>::Intrusive(const Intrusive& r)
+    : Intrusive(r.ptr)
+    {}
+
+    template<class T>
+    Intrusive<T>::Intrusive(Intrusive&& r) noexcept
+    : ptr(r.ptr)
+    {
+        r.ptr = nullptr;
+    }
+
+    template<class T>
+    template<class U>
+    Intrusive<T>::Intrusive(Intrusive<U>&& r) noexcept
+    : ptr(r.ptr)
+    {
+        r.ptr = nullptr;
+    }
+
+    template<class T>
+    Intrusive<T>& Intrusive<T>::operator = (Intrusive r) noexcept
+    {
+        std::swap(ptr, r.ptr);
+        return *this;
+    }
+
+    template<class T>
+    Intrusive<T>::~Intrusive()
+    {
+        if (ptr and ptr->refs.dec())
+            delete ptr;
+    }
+
+    template<class T, class... A>
+    Intrusive<T> _make_shared(std::true_type, A&&... a)
+    {
+        return Intrusive<T>(new T(std::forward<A>(a)...));
+    }
+
+    template<class T, class... A>
+    std::shared_ptr<T> _make_shared(std::false_type, A&&... a)
+    {
+        return std::make_shared<T>(std::forward<A>(a)...);
+    }
+
     template<class T>
     template<class... A>
     Shared<T>::Shared(A&&... a)
-    : impl(std::make_shared<T>(std::forward<A>(a)...))
+    : impl(_make_shared<T>(std::is_base_of<RefCountedBase, T>(), std::forward<A>(a)...))
     {}
 
     template<class T>
@@ -0,0 +1,133 @@
+#include "push_parser.hpp"
+//    push_parser.cpp - Parse S-expressions from input that arrives in pieces.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+
+#include "parser.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    PushParser::PushParser(std::string n)
+    : name(std::move(n))
+    , pending()
+    , pending_offset(0)
+    , pending_lines(0)
+    , pending_column(0)
+    , parsed(0)
+    , scanned(0)
+    , scanner()
+    , eof(false)
+    {}
+
+    void PushParser::feed(const char *data, size_t len)
+    {
+        pending.append(data, len);
+    }
+
+    void PushParser::finish()
+    {
+        eof = true;
+    }
+
+    void PushParser::discard_parsed()
+    {
+        // only once it's most of pending, so that the input is
+        // moved a bounded number of times, however many forms it holds
+        if (!parsed or parsed < pending.size() - parsed)
+            return;
+        size_t nl = pending.rfind('\n', parsed - 1);
+        if (nl == std::string::npos)
+            pending_column += parsed;
+        else
+        {
+            pending_lines += std::count(pending.begin(), pending.begin() + nl + 1, '\n');
+            pending_column = parsed - (nl + 1);
+        }
+        pending_offset += parsed;
+        pending.erase(0, parsed);
+        scanned -= parsed;
+        parsed = 0;
+    }
+
+    /// Whether to wait for more input before scanning the first line.
+    bool PushParser::skip_shebang()
+    {
+#if HANDLE_SHEBANG_SPECIALLY
+        // like parse_parallel, skip it before the scanner sees it,
+        // since it needn't be made of well-formed tokens
+        if (pending_offset or scanned)
+            return false;
+        if (pending.size() < 2)
+            return !eof and (pending.empty() or pending[0] == '#');
+        if (pending[0] != '#' or pending[1] != '!')
+            return false;
+        size_t nl = pending.find('\n');
+        if (nl == std::string::npos)
+        {
+            if (!eof)
+                return true;
+            nl = pending.size() - 1;
+        }
+        parsed = scanned = nl + 1;
+#endif
+        return false;
+    }
+
+    SExpr PushParser::poll()
+    {
+        if (skip_shebang())
+            return Void();
+        while (true)
+        {
+            const char *b = pending.data(), *e = b + pending.size();
+            const char *end = scanner.scan(b + scanned, e);
+            if (end)
+                scanned = end - b;
+            else
+            {
+                scanned = pending.size();
+                if (!eof or !scanner.busy())
+                    return Void();
+                // the last token, or something the lexer will complain about
+                end = e;
+                scanner = FormScanner();
+            }
+
+            // if it's bad, skip it next time
+            size_t from = parsed;
+            parsed = end - b;
+            Parser parser(TrackingStream(name, b, e, b + from, end,
+                        pending_offset, pending_lines, pending_column));
+            SExpr out = parser.next();
+            discard_parsed();
+            // Void if there were only blanks or comments
+            if (!out.is<Void>())
+                return out;
+        }
+    }
+
+    bool PushParser::done()
+    {
+        return eof and scanned == pending.size() and !scanner.busy();
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,69 @@
+#ifndef TMWA_SEXPR_PUSH_PARSER_HPP
+#define TMWA_SEXPR_PUSH_PARSER_HPP
+//    push_parser.hpp - Parse S-expressions from input that arrives in pieces.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <string>
+
+#include "forms.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Unlike Parser, never blocks: feed it whatever bytes have arrived,
+    /// and poll for the forms that they complete.
+    ///
+    /// Each byte is scanned once by a FormScanner as it arrives,
+    /// and once more by a Lexer when its form is complete.
+    class PushParser
+    {
+        std::string name;
+        // unconsumed input, and maybe some that was parsed already
+        std::string pending;
+        // how much of the input came before pending,
+        // and how far into its line pending starts
+        size_t pending_offset, pending_lines, pending_column;
+        // how much of pending has been parsed, or scanned
+        size_t parsed, scanned;
+        FormScanner scanner;
+        bool eof;
+
+        void discard_parsed();
+        bool skip_shebang();
+    public:
+        /// name is only used in error messages
+        explicit PushParser(std::string name);
+
+        void feed(const char *data, size_t len);
+        /// No more data will be fed, so a last token can end.
+        void finish();
+
+        /// Return the next complete form, or Void if there isn't one yet.
+        /// Errors are thrown (as Unexpected) only once the form with
+        /// the error is complete, or at finish().
+        SExpr poll();
+        /// finish() has been called and every form has been polled.
+        bool done();
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_PUSH_PARSER_HPP
@@ -0,0 +1,179 @@
+#include "reader.hpp"
+//    reader.cpp - Read a pipe or terminal on a background thread.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <initializer_list>
+#include <system_error>
+
+#include <cerrno>
+
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    BackgroundReader::BackgroundReader(int f, size_t size, size_t count)
+    : fd(f)
+    , wake()
+    , block_size(size)
+    , blocks(count, std::vector<char>(size))
+    , lengths(count)
+    , produced(0)
+    , consumed(0)
+    , finished(false)
+    , stopping(false)
+    , error(0)
+    , holding(false)
+    , lock()
+    , producer()
+    , consumer()
+    , thread()
+    {
+        producer.asleep = false;
+        consumer.asleep = false;
+        if (pipe2(wake, O_CLOEXEC) < 0)
+            wake[0] = wake[1] = -1;
+        thread = std::thread(&BackgroundReader::run, this);
+    }
+
+    BackgroundReader::~BackgroundReader()
+    {
+        stopping = true;
+        if (wake[1] >= 0)
+        {
+            char c = 0;
+            while (write(wake[1], &c, 1) < 0 and errno == EINTR)
+            {}
+        }
+        wake_up(producer);
+        thread.join();
+        for (int f : {fd, wake[0], wake[1]})
+            if (f >= 0)
+                close(f);
+    }
+
+    // Whoever changes a counter checks `asleep` afterwards, and whoever
+    // goes to sleep sets `asleep` before checking the counters; with the
+    // default (sequentially consistent) ordering, one of them sees the other.
+    template<class Ready>
+    void BackgroundReader::sleep(Sleeper& s, Ready ready)
+    {
+        if (ready())
+            return;
+        std::unique_lock<std::mutex> guard(lock);
+        s.asleep = true;
+        s.cv.wait(guard, ready);
+        s.asleep = false;
+    }
+
+    void BackgroundReader::wake_up(Sleeper& s)
+    {
+        if (s.asleep)
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            s.cv.notify_one();
+        }
+    }
+
+    /// Like poll(2) on fd, but returns -1 when told to stop.
+    int BackgroundReader::poll(int timeout)
+    {
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        int n;
+        while ((n = ::poll(fds, wake[0] >= 0 ? 2 : 1, timeout)) < 0 and errno == EINTR)
+        {}
+        if (stopping or fds[1].revents)
+            return -1;
+        if (n < 0)
+            error = errno;
+        return n;
+    }
+
+    void BackgroundReader::run()
+    {
+        size_t count = blocks.size();
+        bool eof = false;
+        while (!eof)
+        {
+            size_t p = produced;
+            sleep(producer, [&]{ return p - consumed < count or stopping; });
+            if (stopping)
+                break;
+            char *data = blocks[p % count].data();
+            size_t len = 0;
+            // fill the block, but hand it over as soon as nothing is ready
+            while (len < block_size)
+            {
+                if (poll(len ? 0 : -1) <= 0)
+                {
+                    if (!len)
+                        eof = true;
+                    break;
+                }
+                ssize_t n = read(fd, data + len, block_size - len);
+                if (n < 0 and errno == EINTR)
+                    continue;
+                if (n <= 0)
+                {
+                    if (n < 0)
+                        error = errno;
+                    eof = true;
+                    break;
+                }
+                len += n;
+            }
+            if (len)
+            {
+                lengths[p % count] = len;
+                produced = p + 1;
+            }
+            wake_up(consumer);
+        }
+        finished = true;
+        wake_up(consumer);
+    }
+
+    bool BackgroundReader::next(const char *& b, const char *& e)
+    {
+        size_t c = consumed;
+        if (holding)
+        {
+            consumed = ++c;
+            holding = false;
+            wake_up(producer);
+        }
+        // finished is only set after the last block is produced
+        sleep(consumer, [&]{ return produced != c or finished; });
+        if (produced == c)
+        {
+            if (error)
+                throw std::system_error(error, std::generic_category(), "read");
+            return false;
+        }
+        size_t i = c % blocks.size();
+        b = blocks[i].data();
+        e = b + lengths[i];
+        holding = true;
+        return true;
+    }
+} // namespace sexpr
+} // namespace tmwa
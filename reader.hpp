@@ -0,0 +1,87 @@
+#ifndef TMWA_SEXPR_READER_HPP
+#define TMWA_SEXPR_READER_HPP
+//    reader.hpp - Read a pipe or terminal on a background thread.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Owns a file descriptor and a thread that read(2)s it into a ring
+    /// of blocks, while the consumer works through the blocks before them.
+    ///
+    /// Blocks are handed over by publishing counters, with no lock;
+    /// a side only takes the mutex to sleep when it has nothing to do.
+    /// A block is handed over as soon as no more input is ready,
+    /// so a slow source (like someone typing) is not held up.
+    class BackgroundReader
+    {
+        struct Sleeper
+        {
+            std::atomic<bool> asleep;
+            std::condition_variable cv;
+        };
+
+        int fd;
+        // written to by the destructor, to wake the thread from poll(2)
+        int wake[2];
+        size_t block_size;
+        std::vector<std::vector<char>> blocks;
+        std::vector<size_t> lengths;
+        // blocks handed to and given back by the consumer, ever
+        std::atomic<size_t> produced, consumed;
+        std::atomic<bool> finished, stopping;
+        // errno of a failed read, set before finished; 0 at real EOF
+        int error;
+        // whether the consumer has a block it hasn't given back
+        bool holding;
+        std::mutex lock;
+        Sleeper producer, consumer;
+        std::thread thread;
+
+        template<class Ready>
+        void sleep(Sleeper& s, Ready ready);
+        void wake_up(Sleeper& s);
+        int poll(int timeout);
+        void run();
+    public:
+        explicit BackgroundReader(int fd, size_t block_size = 1 << 20, size_t blocks = 4);
+        BackgroundReader(const BackgroundReader&) = delete;
+        BackgroundReader& operator = (const BackgroundReader&) = delete;
+        ~BackgroundReader();
+
+        /// Give back the previous block, and wait for the next one.
+        /// [b, e) is valid until the next call. Returns false at EOF.
+        /// If reading failed, throws std::system_error instead, once
+        /// the blocks read before the failure have been handed out.
+        bool next(const char *& b, const char *& e);
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_READER_HPP
@@ -0,0 +1,54 @@
+#ifndef TMWA_SEXPR_RELOCATE_HPP
+#define TMWA_SEXPR_RELOCATE_HPP
+//    relocate.hpp - Moving objects by copying their bytes.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <type_traits>
+#include <new>
+#include <utility>
+
+#include <cstring>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    template<class... C>
+    struct all_of : std::true_type
+    {};
+    template<class F, class... R>
+    struct all_of<F, R...> : std::integral_constant<bool, F::value and all_of<R...>::value>
+    {};
+
+    /// Whether moving a T and destroying the original is the same as
+    /// copying its bytes, i.e. it doesn't point into itself.
+    /// Specialize it for classes that own memory elsewhere.
+    template<class T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T>
+    {};
+
+    /// Move [b, e) to the uninitialized out, ending the originals.
+    template<class T>
+    void relocate(T *b, T *e, T *out);
+} // namespace sexpr
+} // namespace tmwa
+
+#include "relocate.tcc"
+
+#endif //TMWA_SEXPR_RELOCATE_HPP
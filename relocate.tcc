@@ -0,0 +1,47 @@
+//    relocate.tcc - implementation of inlines and templates in relocate.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+namespace tmwa
+{
+namespace sexpr
+{
+    template<class T>
+    void _relocate(std::true_type, T *b, T *e, T *out)
+    {
+        if (b != e)
+            memcpy(static_cast<void *>(out), static_cast<const void *>(b), (e - b) * sizeof(T));
+    }
+
+    template<class T>
+    void _relocate(std::false_type, T *b, T *e, T *out)
+    {
+        for (; b != e; ++b, ++out)
+        {
+            new (out) T(std::move(*b));
+            b->~T();
+        }
+    }
+
+    template<class T>
+    void relocate(T *b, T *e, T *out)
+    {
+        _relocate(is_trivially_relocatable<T>(), b, e, out);
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,388 @@
+#include "scan.hpp"
+//    scan.cpp - Find interesting characters a block at a time.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <initializer_list>
+
+#if defined(__x86_64__) or defined(__i386__)
+# define SCAN_X86 1
+# include <immintrin.h>
+#else
+# define SCAN_X86 0
+#endif
+
+namespace tmwa
+{
+namespace sexpr
+{
+    static const char *scalar_skip_blanks(const char *b, const char *e)
+    {
+        while (b != e and (*b == ' ' or *b == '\n'))
+            ++b;
+        return b;
+    }
+
+    static const char *scalar_find_token_end(const char *b, const char *e)
+    {
+        for (; b != e; ++b)
+        {
+            char c = *b;
+            if (c == ' ' or c == '\n' or c == '(' or c == ')' or c == '"' or c == '\\')
+                break;
+        }
+        return b;
+    }
+
+    static const char *scalar_find_string_end(const char *b, const char *e)
+    {
+        while (b != e and *b != '"' and *b != '\\')
+            ++b;
+        return b;
+    }
+
+    static const char *scalar_find_control(const char *b, const char *e)
+    {
+        for (; b != e; ++b)
+        {
+            unsigned char c = *b;
+            if (c < ' ' and c != '\n')
+                break;
+        }
+        return b;
+    }
+
+    static const char *scalar_find_string_escape(const char *b, const char *e)
+    {
+        for (; b != e; ++b)
+        {
+            unsigned char c = *b;
+            if (c < ' ' or c >= 0x7f or c == '"' or c == '\\')
+                break;
+        }
+        return b;
+    }
+
+    static const char *scalar_find_token_escape(const char *b, const char *e)
+    {
+        for (; b != e; ++b)
+        {
+            unsigned char c = *b;
+            if (c <= ' ' or c >= 0x7f or c == '"' or c == '\\'
+                    or c == '\'' or c == '(' or c == ')')
+                break;
+        }
+        return b;
+    }
+
+#if SCAN_X86
+    // Each of these produces a mask with a bit set for every byte that
+    // should stop the scan; the tail that doesn't fill a block is left
+    // to the scalar version, so we never read past e.
+
+    __attribute__((target("sse2")))
+    static const char *sse2_skip_blanks(const char *b, const char *e)
+    {
+        const __m128i sp = _mm_set1_epi8(' '), nl = _mm_set1_epi8('\n');
+        for (; e - b >= 16; b += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            __m128i blank = _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl));
+            unsigned mask = ~_mm_movemask_epi8(blank) & 0xffff;
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return scalar_skip_blanks(b, e);
+    }
+
+    __attribute__((target("sse2")))
+    static const char *sse2_find_token_end(const char *b, const char *e)
+    {
+        const __m128i sp = _mm_set1_epi8(' '), nl = _mm_set1_epi8('\n');
+        const __m128i lp = _mm_set1_epi8('('), rp = _mm_set1_epi8(')');
+        const __m128i dq = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\');
+        for (; e - b >= 16; b += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            __m128i stop = _mm_or_si128(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl)),
+                    _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(v, lp), _mm_cmpeq_epi8(v, rp)),
+                        _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs))));
+            unsigned mask = _mm_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return scalar_find_token_end(b, e);
+    }
+
+    __attribute__((target("sse2")))
+    static const char *sse2_find_string_end(const char *b, const char *e)
+    {
+        const __m128i dq = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\');
+        for (; e - b >= 16; b += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs));
+            unsigned mask = _mm_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return scalar_find_string_end(b, e);
+    }
+
+    __attribute__((target("sse2")))
+    static const char *sse2_find_control(const char *b, const char *e)
+    {
+        const __m128i c0_max = _mm_set1_epi8(' ' - 1), nl = _mm_set1_epi8('\n');
+        for (; e - b >= 16; b += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            // unsigned v <= 0x1f iff min(v, 0x1f) == v
+            __m128i c0 = _mm_cmpeq_epi8(_mm_min_epu8(v, c0_max), v);
+            __m128i stop = _mm_andnot_si128(_mm_cmpeq_epi8(v, nl), c0);
+            unsigned mask = _mm_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return scalar_find_control(b, e);
+    }
+
+    // as signed bytes, 0x80 up are negative, so below ' ' too
+    __attribute__((target("sse2")))
+    static const char *sse2_find_string_escape(const char *b, const char *e)
+    {
+        const __m128i sp = _mm_set1_epi8(' '), del = _mm_set1_epi8(0x7f);
+        const __m128i dq = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\');
+        for (; e - b >= 16; b += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            __m128i stop = _mm_or_si128(
+                    _mm_or_si128(_mm_cmplt_epi8(v, sp), _mm_cmpeq_epi8(v, del)),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs)));
+            unsigned mask = _mm_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return scalar_find_string_escape(b, e);
+    }
+
+    __attribute__((target("sse2")))
+    static const char *sse2_find_token_escape(const char *b, const char *e)
+    {
+        const __m128i bang = _mm_set1_epi8('!'), del = _mm_set1_epi8(0x7f);
+        const __m128i dq = _mm_set1_epi8('"'), bs = _mm_set1_epi8('\\');
+        // '\'', '(' and ')' are consecutive
+        const __m128i q_min = _mm_set1_epi8('\'' - 1), q_max = _mm_set1_epi8(')' + 1);
+        for (; e - b >= 16; b += 16)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+            __m128i stop = _mm_or_si128(
+                    _mm_or_si128(_mm_cmplt_epi8(v, bang), _mm_cmpeq_epi8(v, del)),
+                    _mm_or_si128(
+                        _mm_or_si128(_mm_cmpeq_epi8(v, dq), _mm_cmpeq_epi8(v, bs)),
+                        _mm_and_si128(_mm_cmpgt_epi8(v, q_min), _mm_cmplt_epi8(v, q_max))));
+            unsigned mask = _mm_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return scalar_find_token_escape(b, e);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2_skip_blanks(const char *b, const char *e)
+    {
+        const __m256i sp = _mm256_set1_epi8(' '), nl = _mm256_set1_epi8('\n');
+        for (; e - b >= 32; b += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i blank = _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl));
+            unsigned mask = ~unsigned(_mm256_movemask_epi8(blank));
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return sse2_skip_blanks(b, e);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2_find_token_end(const char *b, const char *e)
+    {
+        const __m256i sp = _mm256_set1_epi8(' '), nl = _mm256_set1_epi8('\n');
+        const __m256i lp = _mm256_set1_epi8('('), rp = _mm256_set1_epi8(')');
+        const __m256i dq = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\');
+        for (; e - b >= 32; b += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i stop = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl)),
+                    _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, lp), _mm256_cmpeq_epi8(v, rp)),
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, dq), _mm256_cmpeq_epi8(v, bs))));
+            unsigned mask = _mm256_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return sse2_find_token_end(b, e);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2_find_string_end(const char *b, const char *e)
+    {
+        const __m256i dq = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\');
+        for (; e - b >= 32; b += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, dq), _mm256_cmpeq_epi8(v, bs));
+            unsigned mask = _mm256_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return sse2_find_string_end(b, e);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2_find_control(const char *b, const char *e)
+    {
+        const __m256i c0_max = _mm256_set1_epi8(' ' - 1), nl = _mm256_set1_epi8('\n');
+        for (; e - b >= 32; b += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i c0 = _mm256_cmpeq_epi8(_mm256_min_epu8(v, c0_max), v);
+            __m256i stop = _mm256_andnot_si256(_mm256_cmpeq_epi8(v, nl), c0);
+            unsigned mask = _mm256_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return sse2_find_control(b, e);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2_find_string_escape(const char *b, const char *e)
+    {
+        const __m256i sp = _mm256_set1_epi8(' '), del = _mm256_set1_epi8(0x7f);
+        const __m256i dq = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\');
+        for (; e - b >= 32; b += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i stop = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpgt_epi8(sp, v), _mm256_cmpeq_epi8(v, del)),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, dq), _mm256_cmpeq_epi8(v, bs)));
+            unsigned mask = _mm256_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return sse2_find_string_escape(b, e);
+    }
+
+    __attribute__((target("avx2")))
+    static const char *avx2_find_token_escape(const char *b, const char *e)
+    {
+        const __m256i bang = _mm256_set1_epi8('!'), del = _mm256_set1_epi8(0x7f);
+        const __m256i dq = _mm256_set1_epi8('"'), bs = _mm256_set1_epi8('\\');
+        const __m256i q_min = _mm256_set1_epi8('\'' - 1), q_max = _mm256_set1_epi8(')' + 1);
+        for (; e - b >= 32; b += 32)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b));
+            __m256i stop = _mm256_or_si256(
+                    _mm256_or_si256(_mm256_cmpgt_epi8(bang, v), _mm256_cmpeq_epi8(v, del)),
+                    _mm256_or_si256(
+                        _mm256_or_si256(_mm256_cmpeq_epi8(v, dq), _mm256_cmpeq_epi8(v, bs)),
+                        _mm256_and_si256(_mm256_cmpgt_epi8(v, q_min), _mm256_cmpgt_epi8(q_max, v))));
+            unsigned mask = _mm256_movemask_epi8(stop);
+            if (mask)
+                return b + __builtin_ctz(mask);
+        }
+        return sse2_find_token_escape(b, e);
+    }
+#endif // SCAN_X86
+
+    static ScanFunctions functions_for(ScanImpl impl)
+    {
+        switch (impl)
+        {
+#if SCAN_X86
+        case ScanImpl::avx2:
+            return ScanFunctions{avx2_skip_blanks, avx2_find_token_end, avx2_find_string_end, avx2_find_control,
+                avx2_find_string_escape, avx2_find_token_escape};
+        case ScanImpl::sse2:
+            return ScanFunctions{sse2_skip_blanks, sse2_find_token_end, sse2_find_string_end, sse2_find_control,
+                sse2_find_string_escape, sse2_find_token_escape};
+#endif
+        default:
+            return ScanFunctions{scalar_skip_blanks, scalar_find_token_end, scalar_find_string_end, scalar_find_control,
+                scalar_find_string_escape, scalar_find_token_escape};
+        }
+    }
+
+    bool scan_impl_available(ScanImpl impl)
+    {
+        switch (impl)
+        {
+        case ScanImpl::scalar:
+            return true;
+#if SCAN_X86
+        case ScanImpl::sse2:
+            return __builtin_cpu_supports("sse2");
+        case ScanImpl::avx2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+        }
+    }
+
+    static ScanFunctions best_functions()
+    {
+#if SCAN_X86
+        __builtin_cpu_init();
+#endif
+        // not AVX2: it is behind SSE2 on the short atoms most input has,
+        // and only ahead on strings of kilobytes
+        if (scan_impl_available(ScanImpl::sse2))
+            return functions_for(ScanImpl::sse2);
+        return functions_for(ScanImpl::scalar);
+    }
+
+    // constant initialized, so that it already works while other
+    // translation units are being initialized; they just get the
+    // scalar functions until this one is
+    ScanFunctions scan = {scalar_skip_blanks, scalar_find_token_end, scalar_find_string_end, scalar_find_control,
+        scalar_find_string_escape, scalar_find_token_escape};
+    static bool chose_best = (scan = best_functions(), true);
+
+    void set_scan_impl(ScanImpl impl)
+    {
+        if (scan_impl_available(impl))
+            scan = functions_for(impl);
+    }
+
+    const char *scan_impl_name(ScanImpl impl)
+    {
+        switch (impl)
+        {
+        case ScanImpl::scalar:
+            return "scalar";
+        case ScanImpl::sse2:
+            return "sse2";
+        case ScanImpl::avx2:
+            return "avx2";
+        }
+        return "?";
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,66 @@
+#ifndef TMWA_SEXPR_SCAN_HPP
+#define TMWA_SEXPR_SCAN_HPP
+//    scan.hpp - Find interesting characters a block at a time.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// All of these return e if nothing is found in [b, e).
+    struct ScanFunctions
+    {
+        /// First character that is not ' ' or '\n'.
+        const char *(*skip_blanks)(const char *b, const char *e);
+        /// First character that ends a run of plain token characters:
+        /// ' ', '\n', '(', ')', '"', or '\\'.
+        const char *(*find_token_end)(const char *b, const char *e);
+        /// First character that ends a run of plain string characters:
+        /// '"' or '\\'.
+        const char *(*find_string_end)(const char *b, const char *e);
+        /// First C0 control character other than '\n'.
+        const char *(*find_control)(const char *b, const char *e);
+        /// First character that must be escaped to print it in a string:
+        /// control characters (including '\n'), '"', '\\', and 0x7f up.
+        const char *(*find_string_escape)(const char *b, const char *e);
+        /// First character that must be escaped to print it in a token:
+        /// as for strings, and ' ', '\'', '(' and ')'.
+        const char *(*find_token_escape)(const char *b, const char *e);
+    };
+
+    enum class ScanImpl
+    {
+        scalar,
+        sse2,
+        avx2,
+    };
+
+    /// SSE2 if this CPU supports it, else scalar, chosen at startup
+    /// (before that, during static initialization, it's scalar).
+    /// AVX2 only wins on long strings, so it is only used if set.
+    extern ScanFunctions scan;
+
+    bool scan_impl_available(ScanImpl impl);
+    /// For benchmarking. Only call when no one is scanning.
+    void set_scan_impl(ScanImpl impl);
+    const char *scan_impl_name(ScanImpl impl);
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_SCAN_HPP
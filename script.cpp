@@ -35,6 +35,105 @@ namespace sexpr
         }
     };
 
+    // size classes of 16 bytes, up to the biggest Value there is
+    class ValuePool
+    {
+        constexpr static size_t step = 16, classes = 4;
+        constexpr static size_t slab_size = 64 * 1024;
+        struct Free
+        {
+            Free *next;
+        };
+        Free *free[classes];
+        char *slab, *slab_end;
+    public:
+        ValueCounts counts;
+
+        ValuePool()
+        : free()
+        , slab()
+        , slab_end()
+        , counts()
+        {}
+
+        void *allocate(size_t size)
+        {
+            ++counts.allocated;
+            ++counts.live;
+            size_t c = (size - 1) / step;
+            if (c >= classes)
+                return ::operator new(size);
+            ++counts.pooled;
+            if (Free *f = free[c])
+            {
+                free[c] = f->next;
+                return f;
+            }
+            size = (c + 1) * step;
+            if (size_t(slab_end - slab) < size)
+            {
+                // the tail of the last slab is wasted, but it's small;
+                // slabs are never given back, even at exit, in case a
+                // static is still holding a Value
+                slab = static_cast<char *>(::operator new(slab_size));
+                slab_end = slab + slab_size;
+                counts.slab_bytes += slab_size;
+            }
+            void *out = slab;
+            slab += size;
+            return out;
+        }
+
+        void deallocate(void *p, size_t size)
+        {
+            --counts.live;
+            size_t c = (size - 1) / step;
+            if (c >= classes)
+                return ::operator delete(p);
+            Free *f = static_cast<Free *>(p);
+            f->next = free[c];
+            free[c] = f;
+        }
+    };
+
+    static ValuePool& value_pool()
+    {
+        // constructed by the first Value, so destroyed after the last
+        static ValuePool pool;
+        return pool;
+    }
+
+    void *Value::operator new(size_t size)
+    {
+        return value_pool().allocate(size);
+    }
+
+    void Value::operator delete(void *p, size_t size)
+    {
+        value_pool().deallocate(p, size);
+    }
+
+    ValueCounts value_counts()
+    {
+        return value_pool().counts;
+    }
+
+    Shared<Value> make_int(int64_t v)
+    {
+        if (v < small_int_min or v > small_int_max)
+            return Shared<IntValue>(v);
+        static std::vector<Shared<Value>> cache = []()
+        {
+            std::vector<Shared<Value>> out;
+            out.reserve(small_int_max - small_int_min + 1);
+            for (int64_t i = small_int_min; i <= small_int_max; ++i)
+                out.push_back(Shared<IntValue>(i));
+            return out;
+        }();
+        ++value_pool().counts.cached_ints;
+        return cache[v - small_int_min];
+    }
+
     Shared<Value> nil = Shared<NilValue>();
 
     Evaluable eval_to_nil = [](Environment&, Continuation ret)
@@ -87,7 +186,7 @@ namespace sexpr
             }
             Evaluable operator()(Int i)
             {
-                Shared<Value> vp = Shared<IntValue>(i.value);
+                Shared<Value> vp = make_int(i.value);
                 return [vp] (Environment&, Continuation ret)
                 {
                     ret(vp);
@@ -103,7 +202,7 @@ namespace sexpr
             }
             Evaluable operator()(Token t)
             {
-                std::string varname = std::move(t.value);
+                Symbol varname = t.value;
                 return [varname] (Environment& env, Continuation ret)
                 {
                     auto it = env.find(varname);
@@ -113,6 +212,14 @@ namespace sexpr
                         ret(it->second);
                 };
             }
+            Evaluable operator()(StringRef s)
+            {
+                return (*this)(String(s.value.str()));
+            }
+            Evaluable operator()(TokenRef t)
+            {
+                return (*this)(Token(t.value.begin(), t.value.end()));
+            }
             Evaluable operator()(Void)
             {
                 throw std::logic_error("attempt to compile eof!");
@@ -167,8 +274,8 @@ namespace sexpr
         Evaluable operator()(Environment& env, List args)
         {
             std::vector<Evaluable> eargs;
-            eargs.reserve(std::distance(args.begin(), args.end()));
-            for (SExpr& sexpr : args)
+            eargs.reserve(args.size());
+            for (const SExpr& sexpr : args)
                 eargs.push_back(compile(env, sexpr));
             return FunctionFunctor{impl, std::move(eargs)};
         }
@@ -227,10 +334,11 @@ namespace sexpr
             {
             public:
                 Token operator ()(Token t) { return t; }
+                Token operator ()(TokenRef t) { return Token(t.value.begin(), t.value.end()); }
                 void operator ()(Void) {}
             };
             apply(var, GetIfToken(), args.take_front());
-            std::string varname = std::move(var.value);
+            Symbol varname = var.value;
             if (varname.empty())
                 throw ScriptError("let varname not token");
             if (args.empty())
@@ -289,7 +397,7 @@ namespace sexpr
     {
         return Environment
         {
-            {"builtin", Shared<Callable>(builtins.at("builtin"))},
+            {Symbol("builtin"), Shared<Callable>(builtins.at("builtin"))},
         };
     }
 } // namespace sexpr
@@ -20,10 +20,13 @@
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <memory>
+#include <functional>
 #include <map>
+#include <unordered_map>
 #include <stdexcept>
 #include <iostream>
 
+#include "flq.hpp"
 #include "sexpr.hpp"
 #include "ptr.hpp"
 
@@ -49,7 +52,7 @@ namespace sexpr
 
     class Value;
     class Evaluable;
-    typedef std::map<std::string, Shared<Value>> Environment;
+    typedef std::unordered_map<Symbol, Shared<Value>> Environment;
     typedef std::function<void(Shared<Value>)> Continuation;
     typedef std::function<void(Environment&, Continuation)> EvaluableImplFunction;
     typedef std::function<Shared<Value>(Environment&, flq<Shared<Value>>)> RealFunction;
@@ -57,7 +60,9 @@ namespace sexpr
 
     void warn(const std::string&);
 
-    class Value
+    // scripts run on one thread, so the counts needn't be atomic,
+    // and nor does the pool that Values are allocated from
+    class Value : public RefCounted<PlainCount>
     {
     public:
         virtual int64_t as_int() { warn("Not integer"); return 0; }
@@ -65,8 +70,25 @@ namespace sexpr
         virtual Shared<CallableImpl> as_callable() { /* no warn - handled elsewhere */ return Shared<CallableImpl>(); }
         virtual SExpr repr() = 0;
         virtual ~Value() {}
+
+        static void *operator new(size_t size);
+        static void operator delete(void *p, size_t size);
     };
 
+    /// Running totals, to see what the pool and the int cache save.
+    struct ValueCounts
+    {
+        // Values allocated, and how many of those came from the pool
+        size_t allocated, pooled;
+        // not yet freed
+        size_t live;
+        // the pool's memory
+        size_t slab_bytes;
+        // make_int calls answered from the cache, without allocating
+        size_t cached_ints;
+    };
+    ValueCounts value_counts();
+
     class Evaluable
     {
         Shared<EvaluableImplFunction> impl;
@@ -118,6 +140,10 @@ namespace sexpr
         SExpr repr() override { return Int(value); }
     };
 
+    /// An IntValue, shared if v is small (see small_int_min/max).
+    Shared<Value> make_int(int64_t v);
+    constexpr int64_t small_int_min = -128, small_int_max = 1023;
+
     class StringValue : public Value
     {
         std::string value;
@@ -18,10 +18,186 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+
 namespace tmwa
 {
 namespace sexpr
 {
+    // so that containers move them rather than copy them
+    static_assert(std::is_nothrow_move_constructible<SExpr>::value, "SExpr moves are noexcept");
+    static_assert(std::is_nothrow_move_assignable<SExpr>::value, "SExpr moves are noexcept");
+
+    // FNV-1a, rather than std::hash, so hashes can be kept between runs
+    static uint64_t hash_bytes(uint64_t h, const char *b, const char *e)
+    {
+        for (; b != e; ++b)
+        {
+            h ^= static_cast<unsigned char>(*b);
+            h *= 0x100000001b3;
+        }
+        return h;
+    }
+
+    static uint64_t mix(uint64_t h)
+    {
+        // the splitmix64 finalizer
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111eb;
+        h ^= h >> 31;
+        return h;
+    }
+
+    // a different basis for each kind, so e.g. "x" and x differ
+    constexpr static uint64_t void_basis = 0xcbf29ce484222325;
+    constexpr static uint64_t list_basis = void_basis + 1;
+    constexpr static uint64_t int_basis = void_basis + 2;
+    constexpr static uint64_t string_basis = void_basis + 3;
+    constexpr static uint64_t token_basis = void_basis + 4;
+
+    class Hash
+    {
+    public:
+        uint64_t operator () (Void)
+        {
+            return void_basis;
+        }
+        uint64_t operator () (const List& l)
+        {
+            return l.hash();
+        }
+        uint64_t operator () (const Int& i)
+        {
+            return mix(int_basis ^ i.value);
+        }
+        uint64_t operator () (const String& s)
+        {
+            return hash_bytes(string_basis, s.value.data(), s.value.data() + s.value.size());
+        }
+        uint64_t operator () (const Token& t)
+        {
+            return hash_bytes(token_basis, t.value.begin(), t.value.end());
+        }
+        uint64_t operator () (const StringRef& s)
+        {
+            return hash_bytes(string_basis, s.value.begin(), s.value.end());
+        }
+        uint64_t operator () (const TokenRef& t)
+        {
+            return hash_bytes(token_basis, t.value.begin(), t.value.end());
+        }
+    };
+
+    size_t List::hash() const
+    {
+        size_t cached = hashed.load(std::memory_order_relaxed);
+        if (!cached)
+        {
+            uint64_t h = list_basis;
+            for (const SExpr& sex : *this)
+                h = mix(h ^ sex.hash());
+            h = mix(h ^ size());
+            // 0 means not computed
+            cached = h ? h : 1;
+            hashed.store(cached, std::memory_order_relaxed);
+        }
+        return cached;
+    }
+
+    size_t SExpr::hash() const
+    {
+        // List::hash recurses through here, so skip apply for lists
+        if (const List *l = get_if<List>())
+            return l->hash();
+        uint64_t h;
+        apply(h, Hash(), *this);
+        return h;
+    }
+
+    static Slice text(const String& s)
+    {
+        return Slice(s.value.data(), s.value.data() + s.value.size());
+    }
+    static Slice text(const StringRef& s)
+    {
+        return s.value;
+    }
+    static Slice text(const Token& t)
+    {
+        return Slice(t.value.begin(), t.value.end());
+    }
+    static Slice text(const TokenRef& t)
+    {
+        return t.value;
+    }
+
+    static bool same_text(Slice l, Slice r)
+    {
+        return l.size() == r.size() and std::equal(l.begin(), l.end(), r.begin());
+    }
+
+    class Equal
+    {
+    public:
+        // different kinds
+        template<class L, class R>
+        bool operator () (const L&, const R&)
+        {
+            return false;
+        }
+
+        bool operator () (Void, Void)
+        {
+            return true;
+        }
+        bool operator () (const List& l, const List& r)
+        {
+            if (l.size() != r.size())
+                return false;
+            if (l.empty() or l.begin() == r.begin())
+                return true;
+            // not by the cached hashes: a reference kept across hash()
+            // can leave one stale, and then equal lists would differ
+            for (size_t i = 0; i != l.size(); ++i)
+                if (l[i] != r[i])
+                    return false;
+            return true;
+        }
+        bool operator () (const Int& l, const Int& r)
+        {
+            return l.value == r.value;
+        }
+        bool operator () (const Token& l, const Token& r)
+        {
+            // interned
+            return l.value == r.value;
+        }
+#define SAME_TEXT(L, R)                                         \
+        bool operator () (const L& l, const R& r)               \
+        {                                                       \
+            return same_text(text(l), text(r));                 \
+        }
+        SAME_TEXT(String, String)
+        SAME_TEXT(String, StringRef)
+        SAME_TEXT(StringRef, String)
+        SAME_TEXT(StringRef, StringRef)
+        SAME_TEXT(Token, TokenRef)
+        SAME_TEXT(TokenRef, Token)
+        SAME_TEXT(TokenRef, TokenRef)
+#undef SAME_TEXT
+    };
 
+    bool operator == (const SExpr& l, const SExpr& r)
+    {
+        // comparing lists recurses through here, so skip apply for them
+        const List *ll = l.get_if<List>(), *rl = r.get_if<List>();
+        if (ll and rl)
+            return Equal()(*ll, *rl);
+        bool out;
+        apply(out, Equal(), l, r);
+        return out;
+    }
 } // namespace sexpr
 } // namespace tmwa
@@ -19,27 +19,91 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <atomic>
 #include <string>
 
-#include "flq.hpp"
+#include "arena.hpp"
+#include "symbol.hpp"
 #include "variant.hpp"
+#include "cowq.hpp"
 
 namespace tmwa
 {
 namespace sexpr
 {
     class SExpr;
-    class List : public flq<SExpr>
+    /// Normally on the heap, but a list made with an Arena puts its
+    /// elements there (see Document).
+    ///
+    /// Copies of a heap list share its elements, so copying a tree is
+    /// O(1); copies of an arena list are deep copies onto the heap.
+    ///
+    /// The structural hash is cached, so everything that could change
+    /// the elements (including handing out a mutable reference) forgets
+    /// it. Writing through such a reference after a call to hash() still
+    /// leaves it stale, so only hash() relies on it: comparison always
+    /// looks at the elements.
+    /// Threads may hash the same const list at once: they just compute
+    /// the same value, and the cache is atomic so that's not a race.
+    class List : public cowq<SExpr, ArenaAllocator<SExpr>>
     {
+        typedef cowq<SExpr, ArenaAllocator<SExpr>> Base;
+        // 0 if not computed yet; only a cache, so relaxed is enough
+        mutable std::atomic<size_t> hashed;
+
+        void forget_hash() { hashed.store(0, std::memory_order_relaxed); }
     public:
         template<class... A>
         List(A&&... a)
-        : flq<SExpr>(std::forward<A>(a)...)
+        : Base(std::forward<A>(a)...)
+        , hashed()
         {}
 
         List(std::initializer_list<SExpr> list)
-        : flq<SExpr>(list)
+        : Base(list)
+        , hashed()
+        {}
+
+        // std::atomic has no copy or move, so carry the cache by hand
+        List(const List& r)
+        : Base(r)
+        , hashed(r.hashed.load(std::memory_order_relaxed))
         {}
+        List(List&& r) noexcept
+        : Base(std::move(r))
+        , hashed(r.hashed.load(std::memory_order_relaxed))
+        {}
+        List& operator = (const List& r)
+        {
+            Base::operator = (r);
+            hashed.store(r.hashed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+        List& operator = (List&& r) noexcept
+        {
+            Base::operator = (std::move(r));
+            hashed.store(r.hashed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+
+        size_t hash() const;
+
+        void detach() { forget_hash(); Base::detach(); }
+        SExpr& operator [](size_t i) { forget_hash(); return Base::operator [](i); }
+        const SExpr& operator [](size_t i) const { return Base::operator [](i); }
+        SExpr& front() { forget_hash(); return Base::front(); }
+        const SExpr& front() const { return Base::front(); }
+        SExpr& back() { forget_hash(); return Base::back(); }
+        const SExpr& back() const { return Base::back(); }
+        SExpr take_front();
+        void pop_front() { forget_hash(); Base::pop_front(); }
+        void push_back(SExpr v);
+        template<class... Args>
+        void emplace_back(Args&&... args);
+        iterator begin() { forget_hash(); return Base::begin(); }
+        iterator end() { forget_hash(); return Base::end(); }
+        const_iterator begin() const { return Base::begin(); }
+        const_iterator end() const { return Base::end(); }
     };
 
     class Int
@@ -70,10 +134,11 @@ namespace sexpr
     };
     inline String::String(String&) = default;
 
+    /// Interned, so a Token owns no memory of its own.
     class Token
     {
     public:
-        std::string value;
+        Symbol value;
 
         Token(const Token&) = default;
         Token(Token&);
@@ -87,16 +152,106 @@ namespace sexpr
     };
     inline Token::Token(Token&) = default;
 
-    class SExpr : public Variant<Void, List, Int, String, Token>
+    /// Bytes owned by someone else, e.g. a mapped file.
+    class Slice
+    {
+        const char *b, *e;
+    public:
+        Slice(const char *begin = nullptr, const char *end = nullptr)
+        : b(begin)
+        , e(end)
+        {}
+        const char *begin() const { return b; }
+        const char *end() const { return e; }
+        size_t size() const { return e - b; }
+        bool empty() const { return b == e; }
+        std::string str() const { return std::string(b, e); }
+    };
+
+    /// Like String, but the bytes belong to the buffer it was parsed from.
+    class StringRef
+    {
+    public:
+        Slice value;
+        explicit StringRef(Slice s = Slice())
+        : value(s)
+        {}
+    };
+
+    /// Like Token, but the bytes belong to the buffer it was parsed from.
+    class TokenRef
+    {
+    public:
+        Slice value;
+        explicit TokenRef(Slice s = Slice())
+        : value(s)
+        {}
+    };
+
+    class SExpr : public Variant<Void, List, Int, String, Token, StringRef, TokenRef>
     {
     public:
         SExpr(Void = Void()) {}
-        SExpr(List l) { emplace<List>(l); }
+        SExpr(List l) { emplace<List>(std::move(l)); }
         SExpr(Int i) { emplace<Int>(i); }
-        SExpr(String s) { emplace<String>(s); }
-        SExpr(Token t) { emplace<Token>(t); }
+        SExpr(String s) { emplace<String>(std::move(s)); }
+        SExpr(Token t) { emplace<Token>(std::move(t)); }
+        SExpr(StringRef s) { emplace<StringRef>(s); }
+        SExpr(TokenRef t) { emplace<TokenRef>(t); }
+
+        /// Structural: borrowed atoms hash like their owned equivalents,
+        /// and the result doesn't change between runs.
+        size_t hash() const;
     };
+
+    /// Structural. Lists that share their elements are equal without
+    /// looking at them; otherwise they are compared element by element.
+    bool operator == (const SExpr& l, const SExpr& r);
+    inline bool operator != (const SExpr& l, const SExpr& r) { return !(l == r); }
+
+    inline SExpr List::take_front()
+    {
+        forget_hash();
+        return Base::take_front();
+    }
+
+    inline void List::push_back(SExpr v)
+    {
+        forget_hash();
+        Base::push_back(std::move(v));
+    }
+
+    template<class... Args>
+    void List::emplace_back(Args&&... args)
+    {
+        forget_hash();
+        Base::emplace_back(std::forward<Args>(args)...);
+    }
+
+    template<>
+    struct is_trivially_relocatable<List>
+    : is_trivially_relocatable<cowq<SExpr, ArenaAllocator<SExpr>>>
+    {};
+    template<>
+    struct is_trivially_relocatable<Token> : is_trivially_relocatable<Symbol>
+    {};
+    // not while a String holds a std::string, which may point into itself
+    template<>
+    struct is_trivially_relocatable<SExpr> : is_trivially_relocatable<SExpr::Variant>
+    {};
 } // namespace sexpr
 } // namespace tmwa
 
+namespace std
+{
+    template<>
+    struct hash<tmwa::sexpr::SExpr>
+    {
+        size_t operator()(const tmwa::sexpr::SExpr& s) const
+        {
+            return s.hash();
+        }
+    };
+} // namespace std
+
 #endif //TMWA_SEXPR_SEXPR_HPP
@@ -0,0 +1,102 @@
+#include "symbol.hpp"
+//    symbol.cpp - Interned names.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    namespace
+    {
+        struct Shard
+        {
+            std::mutex lock;
+            // nodes never move, so pointers to the elements stay valid
+            std::unordered_set<std::string> names;
+        };
+        const size_t shard_count = 16;
+    }
+
+    // function statics, so that Symbols may be made during static init
+    static Shard *shards()
+    {
+        static Shard table[shard_count];
+        return table;
+    }
+
+    static const std::string *empty_name()
+    {
+        static const std::string empty;
+        return &empty;
+    }
+
+    // constant-initialized, so safe to use during static init too
+    static std::atomic<size_t> table_bytes(0);
+    static std::atomic<size_t> table_limit(Symbol::default_limit);
+
+    static const std::string *intern(std::string key)
+    {
+        if (key.empty())
+            return empty_name();
+        Shard& shard = shards()[std::hash<std::string>()(key) % shard_count];
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto it = shard.names.find(key);
+        if (it != shard.names.end())
+            return &*it;
+        size_t cost = sizeof(std::string) + key.size();
+        if (table_bytes.fetch_add(cost, std::memory_order_relaxed) + cost
+                > table_limit.load(std::memory_order_relaxed))
+        {
+            table_bytes.fetch_sub(cost, std::memory_order_relaxed);
+            throw TooManySymbols();
+        }
+        return &*shard.names.insert(std::move(key)).first;
+    }
+
+    const char *TooManySymbols::what() const noexcept
+    {
+        return "too many distinct symbols";
+    }
+
+    void Symbol::limit(size_t bytes)
+    {
+        table_limit.store(bytes, std::memory_order_relaxed);
+    }
+
+    Symbol::Symbol()
+    : name(empty_name())
+    {}
+
+    Symbol::Symbol(std::string s)
+    : name(intern(std::move(s)))
+    {}
+
+    Symbol::Symbol(const char *s)
+    : name(intern(std::string(s)))
+    {}
+
+    Symbol::Symbol(const char *b, const char *e)
+    : name(intern(std::string(b, e)))
+    {}
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,92 @@
+#ifndef TMWA_SEXPR_SYMBOL_HPP
+#define TMWA_SEXPR_SYMBOL_HPP
+//    symbol.hpp - Interned names.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <exception>
+#include <functional>
+#include <string>
+
+#include <cstddef>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Thrown instead of interning a new name past Symbol's limit.
+    class TooManySymbols : public std::exception
+    {
+    public:
+        virtual const char *what() const noexcept override;
+    };
+
+    /// An interned string: every Symbol with the same spelling points at
+    /// the same entry of one global table, so copying, comparing and
+    /// hashing don't look at the characters. Entries are never freed,
+    /// so the table has a limit, and input that isn't trusted can't
+    /// grow it without bound.
+    ///
+    /// Interning is thread-safe; the table is split into shards,
+    /// each with its own lock, so parallel parsers rarely wait.
+    class Symbol
+    {
+        const std::string *name;
+    public:
+        static constexpr size_t default_limit = 256 << 20;
+        /// Roughly the bytes the table may take, counting each name's
+        /// std::string as well. Past it, names already interned can
+        /// still be made into Symbols, but new ones throw TooManySymbols.
+        static void limit(size_t bytes);
+
+        /// The empty symbol.
+        Symbol();
+        explicit Symbol(std::string s);
+        explicit Symbol(const char *s);
+        Symbol(const char *b, const char *e);
+
+        const std::string& str() const { return *name; }
+        const char *c_str() const { return name->c_str(); }
+        const char *begin() const { return name->data(); }
+        const char *end() const { return name->data() + name->size(); }
+        size_t size() const { return name->size(); }
+        bool empty() const { return name->empty(); }
+
+        friend bool operator == (Symbol l, Symbol r) { return l.name == r.name; }
+        friend bool operator != (Symbol l, Symbol r) { return l.name != r.name; }
+        /// Not alphabetical, just consistent within a run.
+        friend bool operator < (Symbol l, Symbol r) { return std::less<const std::string *>()(l.name, r.name); }
+        size_t hash() const { return std::hash<const std::string *>()(name); }
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+namespace std
+{
+    template<>
+    struct hash<tmwa::sexpr::Symbol>
+    {
+        size_t operator()(tmwa::sexpr::Symbol s) const
+        {
+            return s.hash();
+        }
+    };
+} // namespace std
+
+#endif //TMWA_SEXPR_SYMBOL_HPP
@@ -18,12 +18,106 @@
 //    You should have received a copy of the GNU General Public License
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+#include <cstring>
+
+#include <fcntl.h>
+
+#include "reader.hpp"
+#include "scan.hpp"
+
 namespace tmwa
 {
 namespace sexpr
 {
-    Unexpected::Unexpected(const Position& pos, const std::string& msg)
+    // file ids are never reused, so a stale Position can't find a new file
+    static std::mutex registry_lock;
+    static std::unordered_map<uint32_t, LineSource *> registry;
+    static uint32_t last_id = 0;
+
+    LineSource::LineSource()
+    : id()
+    , filename()
+    , base_offset()
+    , base_line()
+    , base_column()
+    , lines_lock()
+    , line_starts()
+    , forgotten_lines()
+    , current()
+    , current_end()
+    {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        id = ++last_id;
+        registry[id] = this;
+    }
+
+    LineSource::~LineSource()
+    {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        registry.erase(id);
+    }
+
+    bool LineSource::whole(const char *&, const char *&)
+    {
+        return false;
+    }
+
+    Location locate(const Position& p)
     {
+        std::lock_guard<std::mutex> lock(registry_lock);
+        auto it = registry.find(p.file);
+        if (it == registry.end())
+            return Location{"<unknown>", 0, 0, ""};
+        LineSource *src = it->second;
+        std::lock_guard<std::mutex> lines(src->lines_lock);
+
+        const char *b, *e;
+        bool is_whole = src->whole(b, e);
+        std::vector<size_t>& starts = src->line_starts;
+        if (is_whole and starts.empty())
+        {
+            starts.push_back(0);
+            for (const char *nl = b; (nl = static_cast<const char *>(memchr(nl, '\n', e - nl))); ++nl)
+                starts.push_back(nl + 1 - b);
+            // the source adds a '\n' to an unterminated last line
+            if (b != e and e[-1] != '\n')
+                starts.push_back(e - b + 1);
+        }
+        if (starts.empty())
+            return Location{src->filename, 0, 0, ""};
+
+        size_t offset = p.offset - std::min(p.offset, src->base_offset);
+        auto after = std::upper_bound(starts.begin(), starts.end(), offset);
+        if (after == starts.begin())
+            // forgotten
+            return Location{src->filename, 0, 0, ""};
+        size_t idx = after - starts.begin() - 1;
+        // the first line may have started before the source did
+        size_t column = offset - starts[idx] + (idx ? 0 : src->base_column);
+        Location out{src->filename, src->base_line + src->forgotten_lines + idx + 1, column, ""};
+        if (!idx and src->base_column)
+            // so not all of it can be shown
+            return out;
+        if (is_whole)
+        {
+            size_t lb = std::min<size_t>(starts[idx], e - b);
+            size_t le = idx + 1 < starts.size() ? std::min<size_t>(starts[idx + 1], e - b) : e - b;
+            out.line_contents.assign(b + lb, b + le);
+            if (!out.line_contents.empty() and out.line_contents.back() != '\n')
+                out.line_contents += '\n';
+        }
+        else if (idx + 1 == starts.size())
+            out.line_contents.assign(src->current, src->current_end);
+        return out;
+    }
+
+    Unexpected::Unexpected(const Position& p, const std::string& msg)
+    {
+        Location pos = locate(p);
         std::ostringstream out;
         out << "At " << pos.filename << ':' << pos.line << ':' << pos.column << '\n';
         out << "Unexpected " << msg << '\n';
@@ -51,68 +145,256 @@ namespace sexpr
         return datum;
     }
 
-    void TrackingStream::next_line()
+    class StreamSource : public LineSource
     {
-        if (std::getline(*in, text))
+        Unique<std::istream> in;
+        std::string text;
+    public:
+        StreamSource(Unique<std::istream> i)
+        : in(std::move(i))
+        , text()
+        {}
+
+        bool next_line(const char *& b, const char *& e) override
+        {
+            if (!std::getline(*in, text))
+                return false;
             text += '\n';
-        else
-            text.clear();
-        // hereafter empty text means error
-        line++;
-        col = 0;
-        if (text.empty() and !eof_message.empty())
-            throw Unexpected(position(), eof_message);
-        for (unsigned char c : text)
-            if (c < ' ' and c != '\n')
+            b = text.data();
+            e = b + text.size();
+            return true;
+        }
+    };
+
+    class BufferSource : public LineSource
+    {
+        MappedFile map;
+        // read [pos, end) of [start, whole_end)
+        const char *start, *whole_end, *pos, *end;
+        // only used if the last line has no '\n'
+        std::string tail;
+    public:
+        BufferSource(const char *b, const char *e, const char *from, const char *to)
+        : map()
+        , start(b)
+        , whole_end(e)
+        , pos(from)
+        , end(to)
+        , tail()
+        {}
+
+        BufferSource(MappedFile m)
+        : map(std::move(m))
+        , start(map.begin())
+        , whole_end(map.end())
+        , pos(map.begin())
+        , end(map.end())
+        , tail()
+        {}
+
+        bool whole(const char *& b, const char *& e) override
+        {
+            b = start;
+            e = whole_end;
+            return true;
+        }
+
+        bool next_line(const char *& b, const char *& e) override
+        {
+            if (pos == end)
+                return false;
+            const char *nl = static_cast<const char *>(memchr(pos, '\n', end - pos));
+            if (nl)
             {
-                if (c == '\t')
-                    throw Unexpected(position(), "tab (try the 'expand' program)");
-                if (c == '\r')
-                    throw Unexpected(position(), "carriage return (try the 'dos2unix' program)");
-                throw Unexpected(position(), "C0 control character");
+                b = pos;
+                e = pos = nl + 1;
+                return true;
             }
+            tail.assign(pos, end);
+            tail += '\n';
+            pos = end;
+            b = tail.data();
+            e = b + tail.size();
+            return true;
+        }
+    };
+
+    class ReaderSource : public LineSource
+    {
+        BackgroundReader reader;
+        // the unread part of the reader's current block
+        const char *pos, *end;
+        // only used for lines that don't fit in one block
+        std::string carry;
+    public:
+        ReaderSource(int fd)
+        : reader(fd)
+        , pos()
+        , end()
+        , carry()
+        {}
+
+        bool next_line(const char *& b, const char *& e) override
+        {
+            const char *nl = pos ? static_cast<const char *>(memchr(pos, '\n', end - pos)) : nullptr;
+            if (nl)
+            {
+                b = pos;
+                e = pos = nl + 1;
+                return true;
+            }
+            carry.assign(pos, end);
+            while (reader.next(pos, end))
+            {
+                nl = static_cast<const char *>(memchr(pos, '\n', end - pos));
+                if (nl)
+                {
+                    carry.append(pos, nl + 1);
+                    pos = nl + 1;
+                    b = carry.data();
+                    e = b + carry.size();
+                    return true;
+                }
+                carry.append(pos, end);
+            }
+            pos = end = nullptr;
+            if (carry.empty())
+                return false;
+            carry += '\n';
+            b = carry.data();
+            e = b + carry.size();
+            return true;
+        }
+    };
+
+    static Unique<LineSource> open_source(const std::string& name)
+    {
+        MappedFile map;
+        if (map.open(name))
+            return Unique<BufferSource>(std::move(map));
+        // pipes and terminals are read ahead on another thread
+        int fd = open(name.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+            return Unique<ReaderSource>(fd);
+        return Unique<StreamSource>(Unique<std::ifstream>(name));
     }
 
-    TrackingStream::TrackingStream(std::string name, Unique<std::istream> i)
-    : in(std::move(i))
-    , filename(std::move(name))
-    , text() // initialized later
-    , eof_message()
-#if HANDLE_SHEBANG_SPECIALLY
-    , shebang()
-#endif
-    , line(0)
-    , col(0)
+    void TrackingStream::next_line()
+    {
+        text_offset += text_end - text;
+        if (!in->next_line(text, text_end))
+            // hereafter empty text means error
+            text = text_end = "";
+        cur = text;
+        if (!is_whole)
+        {
+            std::lock_guard<std::mutex> lock(in->lines_lock);
+            in->line_starts.push_back(text_offset);
+            in->current = text;
+            in->current_end = text_end;
+        }
+        if (text == text_end and !eof_message.empty())
+            throw Unexpected(position(), eof_message);
+        const char *bad = scan.find_control(text, text_end);
+        if (bad != text_end)
+        {
+            unsigned char c = *bad;
+            if (c == '\t')
+                throw Unexpected(position(), "tab (try the 'expand' program)");
+            if (c == '\r')
+                throw Unexpected(position(), "carriage return (try the 'dos2unix' program)");
+            throw Unexpected(position(), "C0 control character");
+        }
+    }
+
+    void TrackingStream::start(std::string name, size_t offset)
     {
+        const char *b, *e;
+        in->filename = std::move(name);
+        is_whole = in->whole(b, e);
+        text = cur = text_end = "";
+        text_offset = offset;
         next_line();
 #if HANDLE_SHEBANG_SPECIALLY
-        if (0 == text.compare(0, 2, "#!"))
+        if (offset == 0 and text_end - text >= 2 and text[0] == '#' and text[1] == '!')
         {
-            shebang = std::move(text);
+            shebang.assign(text, text_end);
             next_line();
         }
 #endif
     }
 
+    TrackingStream::TrackingStream(std::string name, Unique<std::istream> i)
+    : in(Unique<StreamSource>(std::move(i)))
+    , eof_message()
+#if HANDLE_SHEBANG_SPECIALLY
+    , shebang()
+#endif
+    , text() // initialized later
+    , cur()
+    , text_end()
+    , text_offset()
+    , is_whole()
+    , keep()
+    , keep_end()
+    {
+        start(std::move(name), 0);
+    }
+
     TrackingStream::TrackingStream(std::string name)
-    : in(Unique<std::ifstream>(name))
-    , filename(std::move(name))
+    : in(open_source(name))
+    , eof_message()
+#if HANDLE_SHEBANG_SPECIALLY
+    , shebang()
+#endif
     , text()
+    , cur()
+    , text_end()
+    , text_offset()
+    , is_whole()
+    , keep()
+    , keep_end()
+    {
+        start(std::move(name), 0);
+    }
+
+    TrackingStream::TrackingStream(std::string name, const char *b, const char *e)
+    : in(Unique<BufferSource>(b, e, b, e))
     , eof_message()
 #if HANDLE_SHEBANG_SPECIALLY
     , shebang()
 #endif
-    , line(0)
-    , col(0)
+    , text()
+    , cur()
+    , text_end()
+    , text_offset()
+    , is_whole()
+    , keep(b)
+    , keep_end(e)
     {
-        next_line();
+        start(std::move(name), 0);
+    }
+
+    TrackingStream::TrackingStream(std::string name,
+            const char *b, const char *e, const char *from, const char *to,
+            size_t offset, size_t lines, size_t column)
+    : in(Unique<BufferSource>(b, e, from, to))
+    , eof_message()
 #if HANDLE_SHEBANG_SPECIALLY
-        if (0 == text.compare(0, 2, "#!"))
-        {
-            shebang = std::move(text);
-            next_line();
-        }
+    , shebang()
 #endif
+    , text()
+    , cur()
+    , text_end()
+    , text_offset()
+    , is_whole()
+    , keep(b)
+    , keep_end(e)
+    {
+        in->base_offset = offset;
+        in->base_line = lines;
+        in->base_column = column;
+        start(std::move(name), offset + (from - b));
     }
 
 #ifdef HANDLE_SHEBANG_SPECIALLY
@@ -122,11 +404,6 @@ namespace sexpr
     }
 #endif
 
-    Position TrackingStream::position()
-    {
-        return {filename, line, col, text};
-    }
-
     void TrackingStream::on_eof(std::string msg)
     {
         eof_message = msg;
@@ -137,21 +414,23 @@ namespace sexpr
         eof_message.clear();
     }
 
-    TrackingStream::operator bool()
-    {
-        return !text.empty();
-    }
-
-    char TrackingStream::operator *()
-    {
-        return text[col];
-    }
-
-    TrackingStream& TrackingStream::operator ++()
+    void TrackingStream::forget_before(const Position& p)
     {
-        if (++col == text.length())
-            next_line();
-        return *this;
+        if (is_whole)
+            return;
+        std::lock_guard<std::mutex> lock(in->lines_lock);
+        std::vector<size_t>& starts = in->line_starts;
+        auto line = std::upper_bound(starts.begin(), starts.end(), p.offset);
+        if (line == starts.begin())
+            return;
+        --line;
+        // only once that's most of them, so each is moved a bounded
+        // number of times, however long the input is
+        size_t n = line - starts.begin();
+        if (n < starts.size() - n)
+            return;
+        starts.erase(starts.begin(), line);
+        in->forgotten_lines += n;
     }
 
     // for *it++, since noncopyable
@@ -20,13 +20,17 @@
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <string>
+#include <vector>
 #include <sstream>
 #include <exception>
 #include <memory>
+#include <mutex>
 #include <istream>
 #include <fstream>
+#include <cstdint>
 
 #include "ptr.hpp"
+#include "mmap.hpp"
 
 /**
  * If 1, TrackingStream detects and skips a shebang line, if present.
@@ -45,13 +49,31 @@ namespace tmwa
 {
 namespace sexpr
 {
+    /// What a lexeme remembers about where it came from.
+    /// Kept small since the lexer takes one for every lexeme;
+    /// use locate() to turn it into something a human can read.
     struct Position
+    {
+        // 0 means unknown
+        uint32_t file;
+        size_t offset;
+    };
+
+    struct Location
     {
         std::string filename;
         size_t line, column;
         std::string line_contents;
     };
 
+    /// Only works while the TrackingStream that made the Position
+    /// is still alive; after that, the file is reported as unknown.
+    ///
+    /// A stream also forgets where lines began once the Lexer is past
+    /// them and the form they were in, so a Position from an earlier
+    /// top-level form may only get the file name. Any thread may call this.
+    Location locate(const Position& pos);
+
     class Unexpected : public std::exception
     {
         std::string message;
@@ -70,19 +92,77 @@ namespace sexpr
         char operator *();
     };
 
+    /// Where a TrackingStream gets its lines from.
+    /// Each one is registered under a file id for the sake of locate().
+    class LineSource
+    {
+        friend class TrackingStream;
+        friend Location locate(const Position&);
+
+        uint32_t id;
+        std::string filename;
+        // if this is only part of the file, how much came before it,
+        // and how far into its line it starts
+        size_t base_offset, base_line, base_column;
+        // locate() may run on another thread while a stream is read,
+        // so the rest is only touched with this held
+        std::mutex lines_lock;
+        // offset of the start of every line read so far, and of EOF.
+        // Maintained as we go for streams, since they forget the text,
+        // except for the first forgotten_lines, which no Lexer needs;
+        // only built by locate() for sources that are wholly in memory.
+        std::vector<size_t> line_starts;
+        size_t forgotten_lines;
+        // so that locate() can show the current line of a stream
+        const char *current, *current_end;
+    protected:
+        LineSource();
+    public:
+        LineSource(const LineSource&) = delete;
+        LineSource& operator = (const LineSource&) = delete;
+        virtual ~LineSource();
+
+        /// Point [b, e) at the next line, which always ends in a '\n'.
+        /// The bytes stay valid until the next call.
+        /// Returns false at end of input.
+        virtual bool next_line(const char *& b, const char *& e) = 0;
+        /// If the whole input is in memory, point [b, e) at it.
+        virtual bool whole(const char *& b, const char *& e);
+    };
+
     class TrackingStream
     {
-        Unique<std::istream> in;
-        std::string filename, text, eof_message;
+        Unique<LineSource> in;
+        std::string eof_message;
 #if HANDLE_SHEBANG_SPECIALLY
         std::string shebang;
 #endif
-        size_t line, col;
+        // the current line is [text, text_end), and points into *in
+        // (or at a static empty string on EOF)
+        const char *text, *cur, *text_end;
+        // of text, counting any '\n' that the source had to add
+        size_t text_offset;
+        bool is_whole;
+        // memory that the caller promised to keep alive, if any
+        const char *keep, *keep_end;
         void next_line();
+        void start(std::string name, size_t offset);
     public:
         TrackingStream(TrackingStream&&) = default;
         TrackingStream(std::string name, Unique<std::istream> i);
+        /// Regular files are mapped, and read without copying.
+        /// Anything else (e.g. /dev/stdin on a pipe) is read by a
+        /// BackgroundReader, so reading overlaps with parsing.
         explicit TrackingStream(std::string name);
+        /// Read from memory that the caller keeps alive.
+        TrackingStream(std::string name, const char *b, const char *e);
+        /// Read just [from, to), out of [b, e) as above.
+        /// b is preceded in the file by offset bytes, which contain the
+        /// given number of lines, and is column bytes into its line.
+        /// (Errors on that line can't show it if column isn't 0.)
+        TrackingStream(std::string name,
+                const char *b, const char *e, const char *from, const char *to,
+                size_t offset, size_t lines, size_t column = 0);
 #ifdef HANDLE_SHEBANG_SPECIALLY
         std::string& get_shebang();
 #endif
@@ -92,10 +172,24 @@ namespace sexpr
         explicit operator bool();
         char operator *();
         TrackingStream& operator ++();
+        /// The rest of the current line is [here(), line_end()),
+        /// for callers that want to scan it in bulk.
+        const char *here();
+        const char *line_end();
+        /// Move to p, which must be in [here(), line_end()].
+        void skip_to(const char *p);
+        /// Whether [b, e) is in memory that outlives this stream,
+        /// i.e. was passed to the (name, b, e) constructor.
+        bool lasting(const char *b, const char *e);
+        /// Nothing before the line that p is in will be located again,
+        /// so a stream needn't remember where those lines began.
+        void forget_before(const Position& p);
         // for *it++, since noncopyable
         FakeTrackingStream operator ++(int);
     };
 } // namespace sexpr
 } // namespace tmwa
 
+#include "tracking_stream.tcc"
+
 #endif //TMWA_SEXPR_TRACKING_STREAM_HPP
@@ -0,0 +1,71 @@
+//    tracking_stream.tcc - implementation of inlines in tracking_stream.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+namespace tmwa
+{
+namespace sexpr
+{
+    // these are called once per character,
+    // only fetching a new line is out of line
+
+    inline Position TrackingStream::position()
+    {
+        return Position{in->id, text_offset + (cur - text)};
+    }
+
+    inline TrackingStream::operator bool()
+    {
+        return cur != text_end;
+    }
+
+    inline char TrackingStream::operator *()
+    {
+        return *cur;
+    }
+
+    inline TrackingStream& TrackingStream::operator ++()
+    {
+        if (++cur == text_end)
+            next_line();
+        return *this;
+    }
+
+    inline const char *TrackingStream::here()
+    {
+        return cur;
+    }
+
+    inline const char *TrackingStream::line_end()
+    {
+        return text_end;
+    }
+
+    inline void TrackingStream::skip_to(const char *p)
+    {
+        cur = p;
+        if (cur == text_end)
+            next_line();
+    }
+
+    inline bool TrackingStream::lasting(const char *b, const char *e)
+    {
+        return keep and keep <= b and e <= keep_end;
+    }
+} // namespace sexpr
+} // namespace tmwa
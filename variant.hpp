@@ -24,9 +24,26 @@
 #include <cstddef>
 #include <utility>
 
+#include "relocate.hpp"
 #include "union.hpp"
 #include "void.hpp"
 
+// apply dispatches with a switch, so the visitor can be inlined into it,
+// rather than through a table of function pointers. Either way, apply
+// on several variants dispatches on each in turn.
+#ifndef VARIANT_DISPATCH_SWITCH
+# define VARIANT_DISPATCH_SWITCH 1
+// # define VARIANT_DISPATCH_SWITCH 0
+#endif
+#if VARIANT_DISPATCH_SWITCH && defined(__OPTIMIZE__)
+// without this, each case is just a call. Unoptimized, forcing it would
+// gain nothing, and only pile every alternative's locals into the frame
+// of each recursive visitor, overflowing the stack on deep trees.
+# define VARIANT_INLINE __attribute__((always_inline)) inline
+#else
+# define VARIANT_INLINE
+#endif
+
 #define WITH_VAR(ty, var, expr)                                         \
     for (bool _with_guard = true; _with_guard; )                        \
         for (ty var = expr; _with_guard; _with_guard = false)           \
@@ -43,6 +60,17 @@ namespace tmwa
 {
 namespace sexpr
 {
+    // bit i is set if b[i] is
+    constexpr uint64_t _bits()
+    {
+        return 0;
+    }
+    template<class... B>
+    constexpr uint64_t _bits(bool b0, B... b)
+    {
+        return uint64_t(b0) | _bits(b...) << 1;
+    }
+
     template<class... T>
     class Variant
     {
@@ -60,7 +88,28 @@ namespace sexpr
         DataType data;
         size_t state;
 
+        // the states whose alternative can be copied as bytes,
+        // and needs no destructor
+        constexpr static uint64_t trivial_states = _bits(
+                std::is_trivially_copyable<D>::value,
+                std::is_trivially_copyable<T>::value...);
+        static_assert(state_count <= 64, "trivial_states has a bit for each state");
+        bool is_trivial() const { return trivial_states >> state & 1; }
+        // so containers can move rather than copy
+        constexpr static bool nothrow_move = all_of<
+                std::is_nothrow_move_constructible<D>,
+                std::is_nothrow_move_constructible<T>...>::value;
+        constexpr static bool nothrow_move_assign = nothrow_move and all_of<
+                std::is_nothrow_move_assignable<D>,
+                std::is_nothrow_move_assignable<T>...>::value;
+        void copy_bytes(const Variant& r);
+
+        template<class U>
+        static void destruct_as(DataType& data);
         void do_destruct();
+        template<class U>
+        static void copy_as(Variant *target, const DataType& data);
+        void do_copy(const Variant& r);
         template<class C, class... A>
         void do_construct(A&&... a);
     public:
@@ -72,9 +121,9 @@ namespace sexpr
         void emplace(A&&... a);
 
         Variant(const Variant& r);
-        Variant(Variant&& r);
+        Variant(Variant&& r) noexcept(nothrow_move);
         Variant& operator = (const Variant& r);
-        Variant& operator = (Variant&& r);
+        Variant& operator = (Variant&& r) noexcept(nothrow_move_assign);
 
         template<class E>
         Variant(E e)
@@ -101,6 +150,54 @@ namespace sexpr
         const E *get_if() const;
     };
 
+    /// Each alternative is in the same place in every Variant,
+    /// so a Variant is only self-referential if one of them is.
+    template<class... T>
+    struct is_trivially_relocatable<Variant<T...>> : all_of<is_trivially_relocatable<T>...>
+    {};
+
+    /// What PackedVariant::get_if returns instead of a pointer,
+    /// since there may be no object to point to.
+    template<class E>
+    class Maybe
+    {
+        bool present;
+        E value;
+    public:
+        Maybe()
+        : present(false)
+        , value()
+        {}
+        explicit Maybe(E v)
+        : present(true)
+        , value(std::move(v))
+        {}
+        explicit operator bool() const { return present; }
+        const E& operator *() const { return value; }
+        const E *operator ->() const { return &value; }
+    };
+
+    /// Visited like a Variant (by apply and MATCH), but Derived decides
+    /// how the alternatives are stored. It must befriend VariantFriend
+    /// and provide:
+    ///     size_t state() const; // index of the current alternative
+    ///     template<class E> E unpack() const; // only called in state E
+    /// The alternatives are handed out by value, so should be cheap.
+    template<class Derived, class D, class... T>
+    class PackedVariant
+    {
+        friend class VariantFriend;
+
+        // only used for index()
+        typedef Union<D, T...> DataType;
+    public:
+        template<class E>
+        bool is() const;
+
+        template<class E>
+        Maybe<E> get_if() const;
+    };
+
     template<class R, class F>
     void apply(R& r, F&& f);
     template<class R, class F, class V1, class... V>
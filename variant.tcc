@@ -18,6 +18,7 @@
 //    along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <cassert>
+#include <cstring>
 #include "bind.hpp"
 
 namespace tmwa
@@ -53,19 +54,101 @@ namespace sexpr
             return std::move(*var.data.template get<E>());
         }
 
+        template<class E, class P, class... T>
+        static E unchecked_get(const PackedVariant<P, T...>& var)
+        {
+            return static_cast<const P&>(var).template unpack<E>();
+        }
+
         template<class E, class R, class F, class V1, class... V>
-        static void _apply_unchecked(R& r, F&& f, V1&& v1, V&&... v)
+        VARIANT_INLINE static void _apply_unchecked(R& r, F&& f, V1&& v1, V&&... v)
         {
             apply(r, bind_variadic(std::forward<F>(f), VariantFriend::unchecked_get<E>(std::forward<V1>(v1))), std::forward<V>(v)...);
         }
 
         template<class... T, class R, class F, class V1, class... V>
-        static void _apply_dispatch(const Variant<T...> *, R& r, F&& f, V1&& v1, V&&... v)
+        static void _apply_table(size_t state, R& r, F&& f, V1&& v1, V&&... v)
         {
             typedef void (*Function)(R&, F&&, V1&&, V&&...);
             constexpr static Function dispatch[sizeof...(T)] = { _apply_unchecked<T, R, F, V1, V...>... };
-            assert(v1.state < sizeof...(T));
-            dispatch[v1.state](r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+            assert(state < sizeof...(T));
+            dispatch[state](r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+        }
+
+        template<size_t I, class F, class... R>
+        struct _Nth
+        {
+            typedef typename _Nth<I - 1, R...>::type type;
+        };
+        template<class F, class... R>
+        struct _Nth<0, F, R...>
+        {
+            typedef F type;
+        };
+
+        // the switch always has this many cases,
+        // the ones past the last alternative being unreachable
+        constexpr static size_t switch_cases = 16;
+
+        template<size_t I, class... T, class R, class F, class V1, class... V>
+        VARIANT_INLINE static void _apply_case(std::true_type, R& r, F&& f, V1&& v1, V&&... v)
+        {
+            _apply_unchecked<typename _Nth<I, T...>::type>(r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+        }
+        template<size_t I, class... T, class R, class F, class V1, class... V>
+        static void _apply_case(std::false_type, R&, F&&, V1&&, V&&...)
+        {
+            __builtin_unreachable();
+        }
+
+        template<class... T, class R, class F, class V1, class... V>
+        VARIANT_INLINE static void _apply_switch(std::true_type, size_t state, R& r, F&& f, V1&& v1, V&&... v)
+        {
+            assert(state < sizeof...(T));
+            switch (state)
+            {
+#define VARIANT_CASE(i)                                                 \
+            case i:                                                     \
+                _apply_case<i, T...>(std::integral_constant<bool, (i < sizeof...(T))>(), \
+                        r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...); \
+                break
+            VARIANT_CASE(0); VARIANT_CASE(1); VARIANT_CASE(2); VARIANT_CASE(3);
+            VARIANT_CASE(4); VARIANT_CASE(5); VARIANT_CASE(6); VARIANT_CASE(7);
+            VARIANT_CASE(8); VARIANT_CASE(9); VARIANT_CASE(10); VARIANT_CASE(11);
+            VARIANT_CASE(12); VARIANT_CASE(13); VARIANT_CASE(14); VARIANT_CASE(15);
+#undef VARIANT_CASE
+            default:
+                __builtin_unreachable();
+            }
+        }
+        // too many alternatives for the switch
+        template<class... T, class R, class F, class V1, class... V>
+        static void _apply_switch(std::false_type, size_t state, R& r, F&& f, V1&& v1, V&&... v)
+        {
+            _apply_table<T...>(state, r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+        }
+
+        template<class... T, class R, class F, class V1, class... V>
+        VARIANT_INLINE static void _apply_state(size_t state, R& r, F&& f, V1&& v1, V&&... v)
+        {
+#if VARIANT_DISPATCH_SWITCH
+            _apply_switch<T...>(std::integral_constant<bool, (sizeof...(T) <= switch_cases)>(),
+                    state, r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+#else
+            _apply_table<T...>(state, r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+#endif
+        }
+
+        template<class... T, class R, class F, class V1, class... V>
+        VARIANT_INLINE static void _apply_dispatch(const Variant<T...> *, R& r, F&& f, V1&& v1, V&&... v)
+        {
+            _apply_state<T...>(v1.state, r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
+        }
+
+        template<class P, class... T, class R, class F, class V1, class... V>
+        VARIANT_INLINE static void _apply_dispatch(const PackedVariant<P, T...> *, R& r, F&& f, V1&& v1, V&&... v)
+        {
+            _apply_state<T...>(get_state(v1), r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
         }
 
         template<class... T>
@@ -74,6 +157,12 @@ namespace sexpr
             return variant.state;
         }
 
+        template<class P, class... T>
+        static size_t get_state(const PackedVariant<P, T...>& variant)
+        {
+            return static_cast<const P&>(variant).state();
+        }
+
         template<class W, class V>
         constexpr static size_t get_state_for()
         {
@@ -82,19 +171,46 @@ namespace sexpr
     };
 
 
-    struct Destruct
+    template<class D, class... T>
+    template<class U>
+    void Variant<D, T...>::destruct_as(DataType& data)
     {
-        template<class U>
-        void operator ()(U& v)
-        {
-            v.~U();
-        }
-    };
+        data.template destruct<U>();
+    }
 
     template<class D, class... T>
     void Variant<D, T...>::do_destruct()
     {
-        apply(Void(), Destruct(), *this);
+        // not through apply: destroying a tree recurses through here,
+        // and apply would inline every alternative into each level
+        typedef void (*Function)(DataType&);
+        constexpr static Function destructors[state_count] = { destruct_as<D>, destruct_as<T>... };
+        if (!is_trivial())
+            destructors[state](data);
+    }
+
+    template<class D, class... T>
+    template<class U>
+    void Variant<D, T...>::copy_as(Variant *target, const DataType& data)
+    {
+        target->template do_construct<U>(*data.template get<U>());
+    }
+
+    template<class D, class... T>
+    void Variant<D, T...>::do_copy(const Variant& r)
+    {
+        // likewise, deep copies (as from an arena) recurse through here
+        typedef void (*Function)(Variant *, const DataType&);
+        constexpr static Function copiers[state_count] = { copy_as<D>, copy_as<T>... };
+        copiers[r.state](this, r.data);
+    }
+
+    template<class D, class... T>
+    void Variant<D, T...>::copy_bytes(const Variant& r)
+    {
+        if (this != &r)
+            memcpy(static_cast<void *>(&data), static_cast<const void *>(&r.data), sizeof(data));
+        state = r.state;
     }
 
     template<class D, class... T>
@@ -143,18 +259,6 @@ namespace sexpr
         do_construct<C, A...>(std::forward<A>(a)...);
     }
 
-    template<class... T>
-    class CopyConstruct
-    {
-        Variant<T...> *target;
-    public:
-        CopyConstruct(Variant<T...> *v) : target(v) {}
-        template<class U>
-        void operator ()(const U& u)
-        {
-            VariantFriend::unchecked_do_construct<U>(target, u);
-        }
-    };
     template<class... T>
     class MoveConstruct
     {
@@ -198,32 +302,42 @@ namespace sexpr
     template<class D, class... T>
     Variant<D, T...>::Variant(const Variant& r)
     {
-        apply(Void(), CopyConstruct<D, T...>(this), r);
+        if (r.is_trivial())
+            copy_bytes(r);
+        else
+            do_copy(r);
     }
 
     template<class D, class... T>
-    Variant<D, T...>::Variant(Variant&& r)
+    Variant<D, T...>::Variant(Variant&& r) noexcept(nothrow_move)
     {
-        apply(Void(), MoveConstruct<D, T...>(this), std::move(r));
+        if (r.is_trivial())
+            copy_bytes(r);
+        else
+            apply(Void(), MoveConstruct<D, T...>(this), std::move(r));
     }
 
     template<class D, class... T>
     Variant<D, T...>& Variant<D, T...>::operator = (const Variant& r)
     {
-        if (state == r.state)
-            apply(Void(), CopyAssign<D, T...>(this), r);
+        if (is_trivial() and r.is_trivial())
+            copy_bytes(r);
+        else if (state == r.state)
+            apply(Void(), CopyAssign<D, T...>(&data), r);
         else
         {
             do_destruct();
-            apply(Void(), CopyConstruct<D, T...>(this), r);
+            do_copy(r);
         }
         return *this;
     }
 
     template<class D, class... T>
-    Variant<D, T...>& Variant<D, T...>::operator = (Variant&& r)
+    Variant<D, T...>& Variant<D, T...>::operator = (Variant&& r) noexcept(nothrow_move_assign)
     {
-        if (state == r.state)
+        if (is_trivial() and r.is_trivial())
+            copy_bytes(r);
+        else if (state == r.state)
             apply(Void(), MoveAssign<D, T...>(&data), std::move(r));
         else
         {
@@ -258,33 +372,49 @@ namespace sexpr
         return nullptr;
     }
 
+    template<class P, class D, class... T>
+    template<class E>
+    bool PackedVariant<P, D, T...>::is() const
+    {
+        return VariantFriend::get_state(*this) == Union<D, T...>::template index<E>();
+    }
+
+    template<class P, class D, class... T>
+    template<class E>
+    Maybe<E> PackedVariant<P, D, T...>::get_if() const
+    {
+        if (is<E>())
+            return Maybe<E>(VariantFriend::unchecked_get<E>(*this));
+        return Maybe<E>();
+    }
+
     template<class R, class F>
-    void _apply_assign(std::true_type, R& r, F&& f)
+    VARIANT_INLINE void _apply_assign(std::true_type, R& r, F&& f)
     {
         std::forward<F>(f)();
         r = Void();
     }
 
     template<class R, class F>
-    void _apply_assign(std::false_type, R& r, F&& f)
+    VARIANT_INLINE void _apply_assign(std::false_type, R& r, F&& f)
     {
         r = std::forward<F>(f)();
     }
 
     template<class R, class F>
-    void apply(R& r, F&& f)
+    VARIANT_INLINE void apply(R& r, F&& f)
     {
         _apply_assign(std::is_void<decltype(std::forward<F>(f)())>(), r, std::forward<F>(f));
     }
 
     template<class R, class F, class V1, class... V>
-    void apply(R& r, F&& f, V1&& v1, V&&... v)
+    VARIANT_INLINE void apply(R& r, F&& f, V1&& v1, V&&... v)
     {
         VariantFriend::_apply_dispatch(&v1, r, std::forward<F>(f), std::forward<V1>(v1), std::forward<V>(v)...);
     }
 
     template<class F, class... V>
-    void apply(Void&& r, F&& f, V&&... v)
+    VARIANT_INLINE void apply(Void&& r, F&& f, V&&... v)
     {
         apply(r, std::forward<F>(f), std::forward<V>(v)...);
     }
@@ -0,0 +1,118 @@
+#include "view.hpp"
+//    view.cpp - Read binary S-expression documents in place.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "parser.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    static SExpr materialize(const SExprView& view, size_t depth)
+    {
+        if (view.is_list())
+        {
+            if (depth >= Lexer::default_max_depth)
+                throw std::length_error("list nested too deeply to materialize");
+            List l;
+            l.reserve(view.size());
+            for (const SExprView& e : view.elements())
+                l.push_back(materialize(e, depth + 1));
+            return SExpr(std::move(l));
+        }
+        if (view.is_int())
+            return Int(view.get_int());
+        if (view.is_string())
+            return StringRef(view.text());
+        if (view.is_token())
+            return TokenRef(view.text());
+        return SExpr();
+    }
+
+    SExpr SExprView::materialize() const
+    {
+        return sexpr::materialize(*this, 0);
+    }
+
+    SExprView ListView::operator [](size_t i) const
+    {
+        assert(i < count);
+        iterator it = begin();
+        while (i--)
+            ++it;
+        return *it;
+    }
+
+    BinaryDocument::BinaryDocument(const std::string& filename)
+    : map()
+    , buf()
+    , b()
+    , e()
+    , symbols()
+    , forms_begin()
+    , form_count()
+    {
+        if (map.open(filename))
+        {
+            b = map.begin();
+            e = map.end();
+        }
+        else
+        {
+            std::ifstream in(filename, std::ios::binary);
+            if (!in)
+                throw std::runtime_error("can't read " + filename);
+            buf.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+            b = buf.data();
+            e = b + buf.size();
+        }
+        load();
+    }
+
+    BinaryDocument::BinaryDocument(const char *begin, const char *end)
+    : map()
+    , buf()
+    , b(begin)
+    , e(end)
+    , symbols()
+    , forms_begin()
+    , form_count()
+    {
+        load();
+    }
+
+    void BinaryDocument::load()
+    {
+        binary::Reader in(b, b, e);
+        uint64_t n = in.start_document();
+        symbols.reserve(n);
+        for (uint64_t i = 0; i != n; ++i)
+            symbols.push_back(in.bytes(in.varint()));
+        form_count = in.varint();
+        if (form_count > static_cast<uint64_t>(e - in.p))
+            in.fail(in.p, "form count exceeds the document");
+        forms_begin = in.p;
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,154 @@
+#ifndef TMWA_SEXPR_VIEW_HPP
+#define TMWA_SEXPR_VIEW_HPP
+//    view.hpp - Read binary S-expression documents in place.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <string>
+#include <vector>
+
+#include <cstdint>
+
+#include "binary.hpp"
+#include "mmap.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    class BinaryDocument;
+    class ListView;
+
+    /// One node of a BinaryDocument, read where it lies instead of
+    /// being decoded. Only its head has been read, so making one is
+    /// O(1) even for a list. Cheap to copy, but must not outlive
+    /// the document.
+    ///
+    /// Asking for the wrong kind of thing (e.g. get_int() of a list)
+    /// is a bug; malformed data is thrown as BadEncoding.
+    class SExprView
+    {
+        const BinaryDocument *doc;
+        // the node is [node, after); a list's elements, or an atom's
+        // bytes, are [body, after)
+        const char *node, *body, *after;
+        uint64_t number;
+        binary::Kind kind;
+    public:
+        /// A nil.
+        SExprView();
+        /// Read the node at in.p, and leave in.p after it.
+        SExprView(const BinaryDocument *d, binary::Reader& in);
+
+        bool is_nil() const;
+        bool is_list() const;
+        bool is_int() const;
+        bool is_string() const;
+        /// Inline or in the symbol table.
+        bool is_token() const;
+
+        int64_t get_int() const;
+        /// The unescaped bytes of a string or token, in the document.
+        Slice text() const;
+        /// The number of elements of a list.
+        size_t size() const;
+        ListView elements() const;
+
+        /// Where the next node begins.
+        const char *end() const;
+
+        /// A heap copy, whose atoms are borrowed from the document.
+        SExpr materialize() const;
+    };
+
+    /// The elements of a list, or the forms of a document.
+    class ListView
+    {
+        const BinaryDocument *doc;
+        const char *b, *e;
+        uint64_t count;
+    public:
+        ListView(const BinaryDocument *d, const char *begin, const char *end, uint64_t n);
+
+        class iterator
+        {
+            const BinaryDocument *doc;
+            binary::Reader in;
+            uint64_t left;
+            SExprView cur;
+
+            void load();
+        public:
+            iterator(const BinaryDocument *d, const char *b, const char *e, uint64_t n);
+
+            const SExprView& operator *() const { return cur; }
+            const SExprView *operator ->() const { return &cur; }
+            iterator& operator ++ ();
+            // only meaningful for iterators of the same list
+            bool operator == (const iterator& r) const { return left == r.left; }
+            bool operator != (const iterator& r) const { return left != r.left; }
+        };
+
+        iterator begin() const;
+        iterator end() const;
+        size_t size() const { return count; }
+        bool empty() const { return !count; }
+        /// O(i), but skips each earlier element in O(1).
+        SExprView operator [](size_t i) const;
+    };
+
+    /// A binary document (see binary.hpp), navigated with SExprViews.
+    ///
+    /// Opening one reads only the header and the symbol table; the rest
+    /// of a mapped file is only paged in as it is looked at, and is
+    /// shared with any other process that maps the same file.
+    ///
+    /// Not movable, since views point at it.
+    class BinaryDocument
+    {
+        MappedFile map;
+        // only used for files that can't be mapped
+        std::string buf;
+        const char *b, *e;
+        std::vector<Slice> symbols;
+        const char *forms_begin;
+        uint64_t form_count;
+
+        void load();
+    public:
+        /// Throws std::runtime_error if the file can't be read.
+        explicit BinaryDocument(const std::string& filename);
+        /// [begin, end) must outlive the document.
+        BinaryDocument(const char *begin, const char *end);
+        BinaryDocument(const BinaryDocument&) = delete;
+        BinaryDocument& operator = (const BinaryDocument&) = delete;
+
+        ListView forms() const;
+        size_t symbol_count() const { return symbols.size(); }
+        Slice symbol(size_t i) const { return symbols[i]; }
+        const char *begin() const { return b; }
+        const char *end() const { return e; }
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#include "view.tcc"
+
+#endif //TMWA_SEXPR_VIEW_HPP
@@ -0,0 +1,177 @@
+//    view.tcc - implementation of inlines and templates in view.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <cassert>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    inline SExprView::SExprView()
+    : doc()
+    , node()
+    , body()
+    , after()
+    , number()
+    , kind(binary::Kind::nil)
+    {}
+
+    inline SExprView::SExprView(const BinaryDocument *d, binary::Reader& in)
+    : doc(d)
+    , node(in.p)
+    , body()
+    , after()
+    , number()
+    , kind(in.head(number))
+    {
+        switch (kind)
+        {
+        case binary::Kind::list:
+        {
+            uint64_t len = in.varint();
+            if (len > static_cast<uint64_t>(in.end - in.p))
+                in.fail(node, "truncated list");
+            // each element is at least one byte
+            if (number > len)
+                in.fail(node, "list count exceeds its length");
+            body = in.p;
+            in.p += len;
+            break;
+        }
+        case binary::Kind::string:
+        case binary::Kind::token:
+            body = in.p;
+            in.bytes(number);
+            break;
+        case binary::Kind::symbol:
+            if (number >= doc->symbol_count())
+                in.fail(node, "symbol index out of range");
+            break;
+        case binary::Kind::nil:
+        case binary::Kind::integer:
+            break;
+        default:
+            in.fail(node, "unknown kind");
+        }
+        after = in.p;
+    }
+
+    inline bool SExprView::is_nil() const
+    {
+        return kind == binary::Kind::nil;
+    }
+
+    inline bool SExprView::is_list() const
+    {
+        return kind == binary::Kind::list;
+    }
+
+    inline bool SExprView::is_int() const
+    {
+        return kind == binary::Kind::integer;
+    }
+
+    inline bool SExprView::is_string() const
+    {
+        return kind == binary::Kind::string;
+    }
+
+    inline bool SExprView::is_token() const
+    {
+        return kind == binary::Kind::token or kind == binary::Kind::symbol;
+    }
+
+    inline int64_t SExprView::get_int() const
+    {
+        assert(is_int());
+        return binary::unzigzag(number);
+    }
+
+    inline Slice SExprView::text() const
+    {
+        assert(is_string() or is_token());
+        if (kind == binary::Kind::symbol)
+            return doc->symbol(number);
+        return Slice(body, after);
+    }
+
+    inline size_t SExprView::size() const
+    {
+        assert(is_list());
+        return number;
+    }
+
+    inline ListView SExprView::elements() const
+    {
+        assert(is_list());
+        return ListView(doc, body, after, number);
+    }
+
+    inline const char *SExprView::end() const
+    {
+        return after;
+    }
+
+    inline ListView::ListView(const BinaryDocument *d, const char *begin, const char *end, uint64_t n)
+    : doc(d)
+    , b(begin)
+    , e(end)
+    , count(n)
+    {}
+
+    inline ListView::iterator::iterator(const BinaryDocument *d, const char *b, const char *e, uint64_t n)
+    : doc(d)
+    , in(d ? d->begin() : b, b, e)
+    , left(n)
+    , cur()
+    {
+        load();
+    }
+
+    inline void ListView::iterator::load()
+    {
+        if (left)
+            cur = SExprView(doc, in);
+        else if (in.p != in.end)
+            in.fail(in.p, "list length doesn't match its elements");
+    }
+
+    inline ListView::iterator& ListView::iterator::operator ++ ()
+    {
+        --left;
+        load();
+        return *this;
+    }
+
+    inline ListView::iterator ListView::begin() const
+    {
+        return iterator(doc, b, e, count);
+    }
+
+    inline ListView::iterator ListView::end() const
+    {
+        return iterator(doc, e, e, 0);
+    }
+
+    inline ListView BinaryDocument::forms() const
+    {
+        return ListView(this, forms_begin, e, form_count);
+    }
+} // namespace sexpr
+} // namespace tmwa
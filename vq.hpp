@@ -0,0 +1,99 @@
+#ifndef TMWA_SEXPR_VQ_HPP
+#define TMWA_SEXPR_VQ_HPP
+//    vq.hpp - Appendable contiguous queue.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <initializer_list>
+#include <memory>
+
+#include <cstddef>
+#include <cstdint>
+
+#include "relocate.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    // like flq, but the elements are contiguous, so it knows its size
+    // and can be indexed; take_front just moves the start along
+    // (the space before it is reused when the storage would grow)
+    template<class T, class A = std::allocator<T>>
+    class vq
+    {
+        A alloc;
+        T *data;
+        // the elements are [data + head, data + tail)
+        uint32_t head, tail, cap;
+
+        void grow();
+        void release();
+    public:
+        vq() : alloc(), data(), head(), tail(), cap() {}
+        explicit vq(const A& a) : alloc(a), data(), head(), tail(), cap() {}
+        // a copy always uses a default-constructed allocator
+        vq(const vq&);
+        vq(vq&&) noexcept;
+        vq& operator = (vq);
+        ~vq();
+        template<class It>
+        vq(It b, It e);
+        vq(std::initializer_list<T> l);
+
+        explicit operator bool() const { return head != tail; }
+        bool empty() const { return head == tail; }
+        size_t size() const { return tail - head; }
+        void reserve(size_t n);
+
+        T& operator [](size_t i) { return data[head + i]; }
+        const T& operator [](size_t i) const { return data[head + i]; }
+        T& front() { return data[head]; }
+        const T& front() const { return data[head]; }
+        T& back() { return data[tail - 1]; }
+        const T& back() const { return data[tail - 1]; }
+
+        T take_front();
+        void pop_front();
+        void pop_back();
+        /// Keeps the storage.
+        void clear();
+        void push_back(T v);
+        template<class... Args>
+        void emplace_back(Args&&... args);
+
+        typedef T *iterator;
+        typedef const T *const_iterator;
+
+        iterator begin() { return data + head; }
+        iterator end() { return data + tail; }
+        const_iterator begin() const { return data + head; }
+        const_iterator end() const { return data + tail; }
+    };
+
+    // owns nothing inside itself
+    template<class T, class A>
+    struct is_trivially_relocatable<vq<T, A>>
+    : std::integral_constant<bool, std::is_empty<A>::value or is_trivially_relocatable<A>::value>
+    {};
+} // namespace sexpr
+} // namespace tmwa
+
+#include "vq.tcc"
+
+#endif //TMWA_SEXPR_VQ_HPP
@@ -0,0 +1,168 @@
+//    vq.tcc - implementation of inlines and templates in vq.hpp
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <algorithm>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    template<class T, class A>
+    vq<T, A>::vq(const vq& r)
+    : alloc(), data(), head(), tail(), cap()
+    {
+        reserve(r.size());
+        for (const T& v : r)
+            new (data + tail++) T(v);
+    }
+
+    template<class T, class A>
+    vq<T, A>::vq(vq&& r) noexcept
+    : alloc(std::move(r.alloc)), data(r.data), head(r.head), tail(r.tail), cap(r.cap)
+    {
+        r.data = nullptr;
+        r.head = r.tail = r.cap = 0;
+    }
+
+    template<class T, class A>
+    vq<T, A>& vq<T, A>::operator = (vq r)
+    {
+        release();
+        alloc = std::move(r.alloc);
+        data = r.data;
+        head = r.head;
+        tail = r.tail;
+        cap = r.cap;
+        r.data = nullptr;
+        r.head = r.tail = r.cap = 0;
+        return *this;
+    }
+
+    template<class T, class A>
+    vq<T, A>::~vq()
+    {
+        release();
+    }
+
+    template<class T, class A>
+    template<class It>
+    vq<T, A>::vq(It b, It e)
+    : alloc(), data(), head(), tail(), cap()
+    {
+        for (; b != e; ++b)
+            push_back(*b);
+    }
+
+    template<class T, class A>
+    vq<T, A>::vq(std::initializer_list<T> l)
+    : alloc(), data(), head(), tail(), cap()
+    {
+        reserve(l.size());
+        for (const T& v : l)
+            new (data + tail++) T(v);
+    }
+
+    template<class T, class A>
+    void vq<T, A>::release()
+    {
+        clear();
+        if (data)
+            alloc.deallocate(data, cap);
+        data = nullptr;
+        head = tail = cap = 0;
+    }
+
+    template<class T, class A>
+    void vq<T, A>::reserve(size_t n)
+    {
+        if (n <= size_t(cap - head))
+            return;
+        if (n > UINT32_MAX)
+            throw std::length_error("vq too long");
+        T *fresh = alloc.allocate(n);
+        uint32_t count = tail - head;
+        relocate(data + head, data + tail, fresh);
+        if (data)
+            alloc.deallocate(data, cap);
+        data = fresh;
+        head = 0;
+        tail = count;
+        cap = n;
+    }
+
+    template<class T, class A>
+    void vq<T, A>::grow()
+    {
+        // most lists are short, so start with room for a few
+        reserve(std::max<size_t>(4, size_t(tail - head) * 2));
+    }
+
+    template<class T, class A>
+    T vq<T, A>::take_front()
+    {
+        T old_front = std::move(data[head]);
+        pop_front();
+        return old_front;
+    }
+
+    template<class T, class A>
+    void vq<T, A>::pop_front()
+    {
+        data[head++].~T();
+        if (head == tail)
+            head = tail = 0;
+    }
+
+    template<class T, class A>
+    void vq<T, A>::pop_back()
+    {
+        data[--tail].~T();
+        if (head == tail)
+            head = tail = 0;
+    }
+
+    template<class T, class A>
+    void vq<T, A>::clear()
+    {
+        for (uint32_t i = head; i != tail; ++i)
+            data[i].~T();
+        head = tail = 0;
+    }
+
+    template<class T, class A>
+    void vq<T, A>::push_back(T v)
+    {
+        if (tail == cap)
+            grow();
+        new (data + tail++) T(std::move(v));
+    }
+
+    template<class T, class A>
+    template<class... Args>
+    void vq<T, A>::emplace_back(Args&&... args)
+    {
+        if (tail == cap)
+            grow();
+        new (data + tail++) T(std::forward<Args>(args)...);
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,123 @@
+#include "writer.hpp"
+//    writer.cpp - Write S-expressions a piece at a time, without a tree.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <stdexcept>
+
+namespace tmwa
+{
+namespace sexpr
+{
+    Writer::Writer(int fd)
+    : out(fd)
+    , open()
+    , first(true)
+    {}
+
+    Writer::Writer(std::ostream& os)
+    : out(os)
+    , open()
+    , first(true)
+    {}
+
+    void Writer::before()
+    {
+        if (!first)
+            out.put(' ');
+        first = false;
+    }
+
+    void Writer::after()
+    {
+        // top-level forms are one per line
+        if (!open)
+        {
+            out.put('\n');
+            first = true;
+        }
+    }
+
+    void Writer::begin_list()
+    {
+        before();
+        out.put('(');
+        ++open;
+        first = true;
+    }
+
+    void Writer::end_list()
+    {
+        if (!open)
+            throw std::logic_error("end_list without begin_list");
+        out.put(')');
+        --open;
+        first = false;
+        after();
+    }
+
+    void Writer::atom_int(int64_t v)
+    {
+        before();
+        out.put_int(v);
+        after();
+    }
+
+    void Writer::atom_string(const char *b, const char *e)
+    {
+        before();
+        out.put_string(b, e);
+        after();
+    }
+
+    void Writer::atom_string(const std::string& s)
+    {
+        atom_string(s.data(), s.data() + s.size());
+    }
+
+    void Writer::atom_token(const char *b, const char *e)
+    {
+        if (b == e)
+            throw std::logic_error("empty token");
+        before();
+        out.put_token(b, e);
+        after();
+    }
+
+    void Writer::atom_token(const std::string& s)
+    {
+        atom_token(s.data(), s.data() + s.size());
+    }
+
+    void Writer::write(const SExpr& sex)
+    {
+        before();
+        if (!out.print(sex))
+            throw std::logic_error("Void has no text form");
+        after();
+    }
+
+    void Writer::finish()
+    {
+        if (open)
+            throw std::logic_error("lists left open at finish");
+        out.flush();
+    }
+} // namespace sexpr
+} // namespace tmwa
@@ -0,0 +1,73 @@
+#ifndef TMWA_SEXPR_WRITER_HPP
+#define TMWA_SEXPR_WRITER_HPP
+//    writer.hpp - Write S-expressions a piece at a time, without a tree.
+//
+//    Copyright © 2026 Ben Longbons <b.r.longbons@gmail.com>
+//
+//    This file is part of The Mana World (Athena server)
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <ostream>
+#include <string>
+
+#include <cstdint>
+
+#include "io.hpp"
+#include "sexpr.hpp"
+
+namespace tmwa
+{
+namespace sexpr
+{
+    /// Writes forms as they are described, so that nothing but the
+    /// open lists is kept in memory. The output is what a Printer
+    /// would print for the equivalent tree, one form per line.
+    ///
+    /// Unbalanced lists and empty tokens, which would not read back
+    /// the same, are thrown as std::logic_error.
+    class Writer
+    {
+        Printer out;
+        size_t open;
+        // at the start of a list, so no space is wanted
+        bool first;
+
+        void before();
+        void after();
+    public:
+        /// fd is not closed.
+        explicit Writer(int fd);
+        explicit Writer(std::ostream& os);
+
+        void begin_list();
+        void end_list();
+        void atom_int(int64_t v);
+        void atom_string(const char *b, const char *e);
+        void atom_string(const std::string& s);
+        void atom_token(const char *b, const char *e);
+        void atom_token(const std::string& s);
+        /// A whole subtree at once.
+        void write(const SExpr& sex);
+
+        /// How many lists are open.
+        size_t depth() const { return open; }
+        /// Check that every list has been ended, and write everything out.
+        void finish();
+    };
+} // namespace sexpr
+} // namespace tmwa
+
+#endif //TMWA_SEXPR_WRITER_HPP